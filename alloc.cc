@@ -0,0 +1,100 @@
+#include "alloc.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+  // Everything here is constant initialized so the thread locals need no
+  // guard, which matters because operator new can run before anything else.
+  thread_local Alloc::Frame current;
+  thread_local Alloc::Frame last;
+
+#ifdef HYDRA_PROFILE
+  static constexpr size_t kMaxDepth = 32;
+
+  thread_local const char* stack[kMaxDepth];
+  thread_local size_t depth;
+
+  Alloc::Stats* scope_stats() {
+    if (depth == 0 || depth > kMaxDepth) return nullptr;
+    const char* name = stack[depth - 1];
+
+    for (size_t i = 0; i < current.scope_count; ++i) {
+      if (current.scopes[i].name == name) return &current.scopes[i].stats;
+    }
+
+    if (current.scope_count == Alloc::kMaxScopes) return nullptr;
+    Alloc::Entry& e = current.scopes[current.scope_count++];
+    e.name = name;
+    e.stats = {};
+    return &e.stats;
+  }
+
+  void count_alloc(size_t size) {
+    ++current.total.count;
+    current.total.bytes += size;
+    if (Alloc::Stats* s = scope_stats()) {
+      ++s->count;
+      s->bytes += size;
+    }
+  }
+
+  void count_free() {
+    ++current.total.frees;
+    if (Alloc::Stats* s = scope_stats()) ++s->frees;
+  }
+
+  void* allocate(size_t size) {
+    count_alloc(size);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+  }
+
+  void release(void* p) {
+    if (!p) return;
+    count_free();
+    std::free(p);
+  }
+#endif
+}
+
+#ifdef HYDRA_PROFILE
+void Alloc::push(const char* name) {
+  if (depth < kMaxDepth) stack[depth] = name;
+  ++depth;
+}
+
+void Alloc::pop() {
+  if (depth > 0) --depth;
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  count_alloc(size);
+  return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  count_alloc(size);
+  return std::malloc(size ? size : 1);
+}
+
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, size_t) noexcept { release(p); }
+void operator delete[](void* p, size_t) noexcept { release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { release(p); }
+#endif
+
+void Alloc::end_frame() {
+  last = current;
+  current.total = {};
+  current.scope_count = 0;
+}
+
+const Alloc::Frame& Alloc::last_frame() {
+  return last;
+}
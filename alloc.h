@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+
+// Heap allocation accounting.  Instrumented builds (HYDRA_PROFILE) replace
+// the global operator new and delete to count allocations and attribute them
+// to the innermost TRACE_SCOPE on the allocating thread.  Otherwise every
+// counter stays at zero and the scope hooks compile away.
+namespace Alloc {
+  struct Stats {
+    size_t count = 0, bytes = 0, frees = 0;
+  };
+
+  struct Entry {
+    const char* name = nullptr;
+    Stats stats;
+  };
+
+  static constexpr size_t kMaxScopes = 64;
+
+  struct Frame {
+    Stats total;
+    size_t scope_count = 0;
+    Entry scopes[kMaxScopes] = {};
+  };
+
+#ifdef HYDRA_PROFILE
+  constexpr bool tracking() { return true; }
+  void push(const char* name);
+  void pop();
+#else
+  constexpr bool tracking() { return false; }
+  inline void push(const char*) {}
+  inline void pop() {}
+#endif
+
+  // closes the calling thread's current frame and starts a new one
+  void end_frame();
+  const Frame& last_frame();
+}
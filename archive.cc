@@ -0,0 +1,110 @@
+#include "archive.h"
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "trace.h"
+
+Archive::Archive(const std::string& path) : data_(nullptr), size_(0), entries_(nullptr), count_(0) {
+  TRACE_SCOPE("Archive::Archive");
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return;
+
+  LARGE_INTEGER size;
+  if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) {
+      data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      size_ = data_ ? (size_t)size.QuadPart : 0;
+      CloseHandle(mapping);
+    }
+  }
+  CloseHandle(file);
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return;
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      data_ = static_cast<const uint8_t*>(p);
+      size_ = st.st_size;
+    }
+  }
+  close(fd);
+#endif
+
+  if (data_ && !validate()) unmap();
+}
+
+Archive::~Archive() {
+  unmap();
+}
+
+const Archive::Entry* Archive::find(entt::id_type hash) const {
+  const Entry* end = entries_ + count_;
+  const Entry* e = std::lower_bound(entries_, end, hash,
+      [](const Entry& a, entt::id_type h) { return a.hash < h; });
+  return e != end && e->hash == hash ? e : nullptr;
+}
+
+SDL_RWops* Archive::open(entt::id_type hash) const {
+  const Entry* e = find(hash);
+  return e ? SDL_RWFromConstMem(data_ + e->offset, (int)e->size) : nullptr;
+}
+
+void Archive::prefetch() const {
+  TRACE_SCOPE("Archive::prefetch");
+  volatile uint8_t sink = 0;
+  for (size_t i = 0; i < size_; i += 4096) sink = sink + data_[i];
+}
+
+bool Archive::validate() {
+  if (size_ < sizeof(Header)) return false;
+
+  Header header;
+  std::memcpy(&header, data_, sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) return false;
+  if (header.version != kVersion) return false;
+  if (sizeof(Header) + (size_t)header.count * sizeof(Entry) > size_) return false;
+
+  entries_ = reinterpret_cast<const Entry*>(data_ + sizeof(Header));
+  count_ = header.count;
+
+  for (uint32_t i = 0; i < count_; ++i) {
+    const Entry& e = entries_[i];
+    if ((size_t)e.offset + e.size > size_) return false;
+    if (i > 0 && entries_[i - 1].hash >= e.hash) return false;
+  }
+
+  return true;
+}
+
+void Archive::unmap() {
+  if (!data_) return;
+
+#ifdef _WIN32
+  UnmapViewOfFile(data_);
+#else
+  munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+
+  data_ = nullptr;
+  size_ = 0;
+  entries_ = nullptr;
+  count_ = 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "entt/core/hashed_string.hpp"
+
+struct SDL_RWops;
+
+// Read only view of a content archive written by pack/pack.cc.  The file
+// starts with a header and an index of entries sorted by the hashed file
+// name; the data follows.  The whole file is memory mapped and entries are
+// handed out as pointers into the mapping, nothing is copied.
+class Archive {
+  public:
+
+    static constexpr char kMagic[4] = { 'H', 'P', 'A', 'K' };
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kAlignment = 16;
+
+    struct Header {
+      char magic[4];
+      uint32_t version;
+      uint32_t count;
+      uint32_t reserved;
+    };
+
+    struct Entry {
+      entt::id_type hash;
+      uint32_t offset;
+      uint32_t size;
+      char name[20];
+    };
+
+    explicit Archive(const std::string& path);
+    ~Archive();
+
+    Archive(const Archive&) = delete;
+    Archive& operator=(const Archive&) = delete;
+
+    operator bool() const { return data_ != nullptr; }
+
+    const Entry* find(entt::id_type hash) const;
+
+    // read only SDL stream over an entry, nullptr if it isn't in the archive
+    SDL_RWops* open(entt::id_type hash) const;
+
+    // faults every page of the mapping in, so a loader thread can take the
+    // disk reads and leave the decoding thread only memory to touch
+    void prefetch() const;
+
+  private:
+
+    const uint8_t* data_;
+    size_t size_;
+    const Entry* entries_;
+    uint32_t count_;
+
+    bool validate();
+    void unmap();
+};
@@ -0,0 +1,222 @@
+#include "assets.h"
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "archive.h"
+#include "trace.h"
+
+using namespace entt::literals;
+
+namespace {
+  constexpr const char* kSamples[] = {
+    "alert.wav", "beep.wav", "dead.wav", "drop.wav", "nope.wav", "nuke.wav",
+    "boom0.wav", "boom1.wav", "boom2.wav", "boom3.wav", "boom4.wav",
+    "hit0.wav", "hit1.wav", "hit2.wav", "hit3.wav", "hit4.wav",
+    "hurt0.wav", "hurt1.wav", "hurt2.wav", "hurt3.wav",
+    "shot0.wav", "shot1.wav", "shot2.wav",
+  };
+
+  constexpr size_t kSampleCount = sizeof(kSamples) / sizeof(kSamples[0]);
+
+  // music is streamed by gam, all we can do is have it in the page cache
+  constexpr const char* kMusic[] = { "battle.ogg", "title.ogg" };
+
+  Mix_Chunk* chunks[kSampleCount] = {};
+
+  // a few samples per title screen frame keeps each frame well under budget
+  constexpr size_t kDecodesPerPoll = 2;
+
+  // SDL_mixer isn't safe to call off the main thread, so the loader only
+  // gets the bytes into memory and poll() or wait() decode them
+  std::string archive_path, samples_source;
+  std::unique_ptr<Archive> archive;
+  std::vector<uint8_t> files[kSampleCount];
+  size_t next_decode = 0;
+  bool started = false, decoded = false;
+
+  std::mutex loader_mutex;
+  std::thread loader;
+  // the loader sets these, samples_read before it moves on to the music
+  std::atomic<bool> samples_read{false}, finished{false};
+
+  // the build and every package put content.pak beside the executable,
+  // which isn't the working directory for make run or bazel run
+  std::string find_archive() {
+    std::string path = "content.pak";
+    if (char* base = SDL_GetBasePath()) {
+      path = base + path;
+      SDL_free(base);
+    }
+    return path;
+  }
+
+  // samples come from the packed archive when there is one, otherwise from
+  // the loose files in content/
+  void read_samples() {
+    TRACE_SCOPE("Assets::read_samples");
+    samples_source = archive_path;
+    archive.reset(new Archive(samples_source));
+    if (!*archive) archive.reset(new Archive(samples_source = "content.pak"));
+    if (*archive) {
+      archive->prefetch();
+      return;
+    }
+
+    samples_source = "content/";
+    for (size_t i = 0; i < kSampleCount; ++i) {
+      FILE* f = fopen(("content/" + std::string(kSamples[i])).c_str(), "rb");
+      if (!f) continue;
+      fseek(f, 0, SEEK_END);
+      const long size = ftell(f);
+      fseek(f, 0, SEEK_SET);
+      files[i].resize(size > 0 ? size : 0);
+      if (fread(files[i].data(), 1, files[i].size(), f) != files[i].size()) files[i].clear();
+      fclose(f);
+    }
+  }
+
+  // decodes up to count more samples, releasing the bytes once all are
+  void decode_samples(size_t count) {
+    TRACE_SCOPE("Assets::decode_samples");
+    for (; next_decode < kSampleCount && count > 0; ++next_decode, --count) {
+      const size_t i = next_decode;
+      if (chunks[i]) continue;
+
+      SDL_RWops* rw = nullptr;
+      if (archive && *archive) {
+        rw = archive->open(entt::hashed_string::value(kSamples[i]));
+      } else if (!files[i].empty()) {
+        rw = SDL_RWFromConstMem(files[i].data(), (int)files[i].size());
+      }
+      if (rw) chunks[i] = Mix_LoadWAV_RW(rw, 1);
+
+      files[i].clear();
+      files[i].shrink_to_fit();
+    }
+    if (next_decode < kSampleCount) return;
+
+    // the chunks hold their own decoded copy
+    archive.reset();
+    decoded = true;
+  }
+
+  // every id is a compile time constant, a miss is a typo in the name
+  [[noreturn]] void unknown(const char* kind, Assets::Id id) {
+    fprintf(stderr, "no %s asset with id %08x\n", kind, (unsigned)id);
+    std::abort();
+  }
+
+  void prefetch_music() {
+    TRACE_SCOPE("Assets::prefetch_music");
+    static char buffer[64 * 1024];
+    for (const char* music : kMusic) {
+      FILE* f = fopen(("content/" + std::string(music)).c_str(), "rb");
+      if (!f) continue;
+      while (fread(buffer, 1, sizeof(buffer), f) == sizeof(buffer)) {}
+      fclose(f);
+    }
+  }
+}
+
+void Assets::preload() {
+#ifdef __EMSCRIPTEN__
+  if (started) return;
+  started = true;
+  archive_path = find_archive();
+  read_samples();
+  decode_samples(kSampleCount);
+#else
+  const std::lock_guard<std::mutex> lock(loader_mutex);
+  if (started) return;
+  started = true;
+  samples_read = false;
+  finished = false;
+  archive_path = find_archive();
+  loader = std::thread([] {
+    read_samples();
+    samples_read = true;
+    prefetch_music();
+    finished = true;
+  });
+#endif
+}
+
+void Assets::poll() {
+  const std::lock_guard<std::mutex> lock(loader_mutex);
+  if (!started) return;
+  if (!decoded && samples_read) decode_samples(kDecodesPerPoll);
+  if (finished && loader.joinable()) loader.join();
+}
+
+void Assets::wait() {
+  const std::lock_guard<std::mutex> lock(loader_mutex);
+  if (!started) return;
+  if (loader.joinable()) loader.join();
+  if (!decoded) decode_samples(kSampleCount);
+}
+
+void Assets::unload() {
+  wait();
+  for (auto& chunk : chunks) {
+    if (chunk) Mix_FreeChunk(chunk);
+    chunk = nullptr;
+  }
+  next_decode = 0;
+  started = decoded = false;
+}
+
+const std::string& Assets::source() {
+  wait();
+  return samples_source;
+}
+
+size_t Assets::sample(Id id) {
+  wait();
+  for (size_t i = 0; i < kSampleCount; ++i) {
+    if (entt::hashed_string::value(kSamples[i]) == id) return i;
+  }
+  return kNoSample;
+}
+
+void Assets::play_sample(Audio& audio, size_t slot, uint8_t distance) {
+  if (slot >= kSampleCount) return;
+
+  // Audio only loads samples by path, so the ones that came out of the
+  // archive are played on the channels it opened
+  if (chunks[slot]) {
+    // channels are reused, a near sound has to clear the last one's distance
+    const int channel = Mix_PlayChannel(-1, chunks[slot], 0);
+    if (channel >= 0) Mix_SetDistance(channel, distance);
+  } else {
+    audio.play_sample(kSamples[slot]);
+  }
+}
+
+const Text& Assets::text(Id id) {
+  static const Text text("text.png", 16);
+
+  switch (id) {
+    case "text.png"_hs: return text;
+    default: unknown("text", id);
+  }
+}
+
+const SpriteMap& Assets::sprites(Id id) {
+  static const SpriteMap hydra("hydra.png", 5, 200, 200);
+
+  switch (id) {
+    case "hydra.png"_hs: return hydra;
+    default: unknown("sprite map", id);
+  }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "entt/core/hashed_string.hpp"
+
+#include "audio.h"
+#include "spritemap.h"
+#include "text.h"
+
+// Process wide asset cache shared by every screen.  Assets are named with
+// compile time hashed ids ("boom0.wav"_hs) which are resolved to a table
+// slot once.  Samples are read up front on a background thread, decoded a
+// few at a time on the main thread while the title screen runs and stay
+// resident, so playing one is an array index rather than a file name build
+// and map lookup.
+namespace Assets {
+  using Id = entt::id_type;
+
+  static constexpr size_t kNoSample = static_cast<size_t>(-1);
+
+  // starts reading every sample in the background and pulls the music
+  // files into the page cache, gam still opens and streams those itself
+  void preload();
+  // decodes a couple of samples once the loader has read them and returns
+  // straight away, for screens shown before the game to call every frame
+  void poll();
+  // finishes the preload and decodes whatever poll hasn't yet.  Both are
+  // main thread only since they call into SDL_mixer, which needs to be open
+  void wait();
+  // frees the samples, before the mixer closes
+  void unload();
+  // the archive the samples were read from, or content/ for loose files
+  const std::string& source();
+
+  // waits for the preload to finish before resolving, kNoSample for a name
+  // that isn't a sample
+  size_t sample(Id id);
+  // distance runs from 0 at the listener to 255 at the edge of hearing; a
+  // sample that didn't decode falls back to Audio loading it by name, which
+  // always plays at full volume
+  void play_sample(Audio& audio, size_t slot, uint8_t distance = 0);
+
+  // unknown ids abort, there is nothing sensible to draw instead
+  const Text& text(Id id);
+  const SpriteMap& sprites(Id id);
+}
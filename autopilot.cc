@@ -0,0 +1,140 @@
+#include "autopilot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include "components.h"
+#include "trace.h"
+
+namespace {
+  std::atomic<bool> flying{false};
+
+  // farthest a target is worth turning for, about half the screen
+  constexpr float kRange = 600.0f;
+  // how far ahead an asteroid's path is checked, and how wide a berth it gets
+  constexpr float kLookahead = 1.5f;
+  constexpr float kBerth = 60.0f;
+  // a bomb's blast reaches 200, stay well clear until it has faded
+  constexpr float kBlastClear = 260.0f;
+  constexpr float kFuse = 1.5f;
+  // enemies inside this radius that make a bomb worth it
+  constexpr float kClusterRadius = 200.0f;
+  constexpr size_t kCluster = 12;
+  // drift this far from the middle and the pilot heads back
+  constexpr float kLeash = 250.0f;
+  // matches Firing's default spread and the bullet speed added in firing
+  constexpr float kAimed = 0.15f;
+  constexpr float kBulletSpeed = 350.0f;
+
+  float wrap(float a) {
+    return std::remainder(a, 2.0f * (float)M_PI);
+  }
+
+  // turns toward heading, and reports whether the ship is pointing there
+  bool turn(Simulation::Controls& c, float angle, float heading, float within) {
+    const float delta = wrap(heading - angle);
+    c.left = delta < -0.05f;
+    c.right = delta > 0.05f;
+    return std::abs(delta) < within;
+  }
+}
+
+void Autopilot::enable(bool enabled) {
+  flying = enabled;
+}
+
+bool Autopilot::enabled() {
+  return flying;
+}
+
+Simulation::Controls Autopilot::fly(const Simulation& sim) {
+  TRACE_SCOPE("Autopilot::fly");
+  Simulation::Controls c;
+  if (sim.state() != Simulation::State::playing) return c;
+
+  const entt::registry& reg = sim.registry();
+  const auto players = reg.view<const PlayerControl, const Position, const Angle, const Velocity>();
+  if (players.begin() == players.end()) return c;
+
+  const auto player = *players.begin();
+  const pos p = players.get<const Position>(player).p;
+  const float angle = players.get<const Angle>(player).angle;
+  const float speed = players.get<const Velocity>(player).vel;
+
+  // the closest thing to flee from: a bomb about to go off or an asteroid
+  // that will pass too close, measured at the moment of closest approach
+  float danger = kBlastClear * kBlastClear;
+  bool fleeing = false;
+  pos away;
+
+  const auto flee = [&](pos from) {
+    const pos d = p - from;
+    const float d2 = d.dist2({});
+    if (d2 < danger) {
+      danger = d2;
+      away = d;
+      fleeing = true;
+    }
+  };
+
+  // stay with a fresh bomb so the swarm chasing the ship is still on top of
+  // it, and only run in the last moments of the fuse
+  const auto bombs = reg.view<const Bomb, const Position>();
+  for (const auto b : bombs) {
+    if (bombs.get<const Bomb>(b).time < kFuse) flee(bombs.get<const Position>(b).p);
+  }
+  const auto blasts = reg.view<const Blast, const Position>();
+  for (const auto b : blasts) flee(blasts.get<const Position>(b).p);
+
+  const auto bodies = reg.view<const Collision, const Position, const Polygon, const Velocity, const Angle>(entt::exclude<Distant>);
+  size_t cluster = 0;
+  entt::entity target = entt::null;
+  float nearest = kRange * kRange;
+
+  for (const auto e : bodies) {
+    const pos q = bodies.get<const Position>(e).p;
+    const float d2 = q.dist2(p);
+    const Polygon& poly = bodies.get<const Polygon>(e);
+
+    if (d2 < kClusterRadius * kClusterRadius) ++cluster;
+    if (d2 < nearest) {
+      nearest = d2;
+      target = e;
+    }
+
+    if (fleeing || Shapes::kind(poly.shape) != Shapes::Kind::asteroid) continue;
+
+    // relative motion, the asteroid's path past the ship
+    const pos rel = q - p;
+    const pos vel = pos::polar(bodies.get<const Velocity>(e).vel, bodies.get<const Angle>(e).angle) - pos::polar(speed, angle);
+    const float v2 = vel.dist2({});
+    const float t = v2 > 0 ? std::clamp(-(rel.x * vel.x + rel.y * vel.y) / v2, 0.0f, kLookahead) : 0.0f;
+    const pos closest = rel + vel * t;
+
+    const float reach = Shapes::get(poly.shape).radius * poly.scale + kBerth;
+    if (closest.dist2({}) < reach * reach) {
+      // sidestep across the asteroid's path rather than racing it
+      const pos side = { -vel.y, vel.x };
+      away = (side.x * rel.x + side.y * rel.y) > 0 ? side * -1.0f : side;
+      fleeing = true;
+    }
+  }
+
+  if (fleeing) {
+    c.thrust = turn(c, angle, away.angle(), 0.6f);
+  } else if (target != entt::null) {
+    // lead the target by the time a bullet takes to get there
+    const pos q = bodies.get<const Position>(target).p;
+    const pos v = pos::polar(bodies.get<const Velocity>(target).vel, bodies.get<const Angle>(target).angle);
+    const float flight = std::sqrt(nearest) / (speed + kBulletSpeed);
+    c.fire = turn(c, angle, (q + v * flight - p).angle(), kAimed);
+  } else {
+    const pos center = { sim.settings().width / 2.0f, sim.settings().height / 2.0f };
+    if (center.dist2(p) > kLeash * kLeash) c.thrust = turn(c, angle, (center - p).angle(), 0.3f);
+  }
+
+  // bunched up enemies are worth a bomb, getting clear of it comes later
+  c.bomb = cluster >= kCluster && sim.bombs_left() > 0 && sim.bomb_cooldown() <= 0;
+  return c;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "simulation.h"
+
+// Computer pilot for automated load.  Reads the simulation the way a player
+// reads the screen and answers with the same Controls a gamepad produces,
+// so the player ship is flown through user_input like any other game:
+// it turns to lead the nearest threat and fires once lined up, steers away
+// from asteroids on a collision course and from its own bombs, and drops a
+// bomb when enough enemies have bunched up around it.  It keeps no state
+// of its own, so the same game plays out the same way every time.
+namespace Autopilot {
+  // process wide switch GameScreen checks, set from HYDRA_AUTOPILOT or bench
+  void enable(bool enabled);
+  bool enabled();
+
+  Simulation::Controls fly(const Simulation& sim);
+}
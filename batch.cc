@@ -0,0 +1,61 @@
+#include "batch.h"
+
+#include <chrono>
+#include <vector>
+
+#include "autopilot.h"
+#include "simulation.h"
+#include "trace.h"
+#include "workers.h"
+
+namespace {
+  constexpr float kStep = 1 / 60.0f;
+
+  Batch::Run play(const Batch::Settings& settings, uint64_t seed) {
+    TRACE_SCOPE("Batch::play");
+
+    Simulation::Settings s;
+    s.width = settings.width;
+    s.height = settings.height;
+    s.seed = seed;
+    s.effects = false;
+    s.parallel = false;
+
+    Simulation sim(s);
+    const Simulation::Controls idle;
+
+    size_t frames = 0;
+    while (frames < settings.frames && sim.state() != Simulation::State::lost) {
+      sim.step(settings.autopilot ? Autopilot::fly(sim) : idle, kStep);
+      ++frames;
+    }
+
+    std::vector<uint8_t> state;
+    sim.save(state);
+    uint64_t digest = 0xcbf29ce484222325ull;
+    for (const uint8_t b : state) digest = (digest ^ b) * 0x100000001b3ull;
+
+    const bool lost = sim.state() == Simulation::State::lost;
+    return { seed, sim.score(), sim.best_combo(), lost ? sim.survived() : sim.clock(), lost, frames, digest };
+  }
+}
+
+Batch::Report Batch::run(const Settings& settings) {
+  TRACE_SCOPE("Batch::run");
+
+  Report report;
+  report.runs.resize(settings.runs);
+  report.threads = Workers::count();
+
+  const auto start = std::chrono::steady_clock::now();
+  // one whole game per item, the pool hands the next seed to whichever
+  // thread finishes first
+  Workers::parallel_for(settings.runs, 1, [&](size_t begin, size_t end, size_t) {
+    for (size_t i = begin; i < end; ++i) report.runs[i] = play(settings, settings.seed + i);
+  });
+  report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  report.frames = 0;
+  for (const auto& r : report.runs) report.frames += r.frames;
+  return report;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Many complete games played headless at once, for tuning spawn curves and
+// soak testing.  Each run is its own Simulation stepped at 60 Hz on one
+// worker thread, without effects and without splitting its own systems, so
+// runs share nothing they write and a batch scales with the cores.  Run i
+// plays seed + i, so a batch replays exactly.
+namespace Batch {
+  struct Settings {
+    size_t runs = 64;
+    uint64_t seed = 1;
+    // a run ends when the player dies or after this many frames
+    size_t frames = 60 * 60 * 10;
+    // flown by the autopilot, otherwise the ship sits still until it dies
+    bool autopilot = true;
+    float width, height;
+  };
+
+  struct Run {
+    uint64_t seed;
+    int score, best_combo;
+    // seconds of game time the player lasted, the whole run if they lived
+    float survived;
+    bool lost;
+    size_t frames;
+    // FNV-1a of the saved final state, equal only when the games matched
+    uint64_t digest;
+  };
+
+  struct Report {
+    std::vector<Run> runs;
+    size_t threads, frames;
+    double seconds;
+
+    // simulated frames per second of wall time over every thread
+    double fps() const { return seconds > 0 ? frames / seconds : 0; }
+  };
+
+  Report run(const Settings& settings);
+}
@@ -0,0 +1,352 @@
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio.h"
+#include "graphics.h"
+#include "input.h"
+
+#include "alloc.h"
+#include "assets.h"
+#include "autopilot.h"
+#include "batch.h"
+#include "config.h"
+#include "game_screen.h"
+#include "histogram.h"
+#include "quality.h"
+#include "rewind.h"
+#include "telemetry.h"
+#include "workers.h"
+
+// Headless benchmark: runs a GameScreen at a fixed 60 Hz step, updating and
+// drawing it through SDL's dummy video driver, and reports sample load
+// time, update and draw time, how many entities ran the full or distant
+// simulation tier and, in instrumented builds, heap allocations per frame
+// and per system.  Samples are read from content.pak next to the
+// executable when it exists.  The load line is how long starting a game
+// stalls after -T frames of title screen (60 by default); -T 0 starts one
+// straight away, so running that with and without the archive compares
+// cold start from the archive against loose files.
+//
+//   bench [-f frames] [-w warmup] [-b budget] [-j threads] [-r hz] [-t csv] [-a 1] [-s MiB] [-T frames]
+//   bench -n runs [-f frames] [-j threads] [-a 0]
+//
+// With a budget, any frame after the warmup that allocates more than budget
+// times makes the run fail, so steady state allocations can't creep in.
+// make check runs the instrumented bench that way.
+// -j sets the worker pool size (default one per core), -j 1 runs every
+// system on the main thread for comparison.  -r sets the frame rate the
+// quality governor budgets for, the report shows where it settled.  -t
+// writes pool telemetry to a CSV file.  Pool growth is watched either way,
+// so a long soak run (-f 216000 is an hour of game time) fails when any
+// population keeps climbing.  -a 1 hands the ship to the autopilot so the
+// frames measured are full of bullets, explosions and bombs.  -s keeps a
+// rewind history of that many MiB and reports what recording it costs per
+// frame, how well the deltas pack and how long the oldest frame takes to
+// restore; restoring has to give back the exact bytes that were saved.
+//
+// With -n the bench plays that many whole games headless instead, one per
+// worker thread at a time and each capped at -f frames, and reports the
+// simulated frames per second across all of them along with how each run
+// went.  Batch games are flown by the autopilot unless -a 0.  -d 1 plays
+// the batch a second time on the main thread alone and fails unless every
+// run ends in exactly the same state, so threads can't change an outcome.
+//
+// bench/compare.sh rev [arguments] runs the same arguments against bench
+// built at another revision, for before and after numbers.
+
+namespace {
+  struct Totals {
+    size_t frames = 0;
+    Alloc::Stats total;
+    size_t worst = 0;
+    size_t scope_count = 0;
+    std::array<Alloc::Entry, Alloc::kMaxScopes> scopes;
+
+    void add(const Alloc::Frame& frame) {
+      ++frames;
+      total.count += frame.total.count;
+      total.bytes += frame.total.bytes;
+      worst = std::max(worst, frame.total.count);
+
+      for (size_t i = 0; i < frame.scope_count; ++i) {
+        const Alloc::Entry& e = frame.scopes[i];
+        auto it = std::find_if(scopes.begin(), scopes.begin() + scope_count,
+            [&e](const Alloc::Entry& o) { return o.name == e.name; });
+        if (it == scopes.begin() + scope_count) {
+          if (scope_count == scopes.size()) continue;
+          *it = { e.name, {} };
+          ++scope_count;
+        }
+        it->stats.count += e.stats.count;
+        it->stats.bytes += e.stats.bytes;
+      }
+    }
+  };
+
+  void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-f frames] [-w warmup] [-b budget] [-j threads] [-r hz] [-t csv] [-a 1] [-s MiB] [-T frames]\n"
+        "       %s -n runs [-f frames] [-j threads] [-a 0] [-d 1]\n", name, name);
+    exit(2);
+  }
+
+  struct RewindReport {
+    Rewind::Stats stats;
+    double restore_ms;
+    bool matches;
+  };
+
+  // restores the latest and the oldest frame into a spare game, the latest
+  // has to come back byte for byte
+  RewindReport rewind(const Simulation& sim) {
+    RewindReport report = { Rewind::stats(), 0, true };
+    if (report.stats.frames == 0) return report;
+
+    Simulation copy(sim.settings());
+    std::vector<uint8_t> saved, restored;
+    sim.save(saved);
+    Rewind::restore(0, copy);
+    copy.save(restored);
+    report.matches = saved == restored;
+
+    const auto start = std::chrono::steady_clock::now();
+    Rewind::restore(report.stats.frames - 1, copy);
+    report.restore_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return report;
+  }
+
+  int batch(size_t runs, size_t frames, bool autopilot, bool determinism) {
+    Batch::Settings settings;
+    settings.runs = runs;
+    settings.frames = frames;
+    settings.autopilot = autopilot;
+    settings.width = kConfig.graphics.width;
+    settings.height = kConfig.graphics.height;
+
+    const Batch::Report report = Batch::run(settings);
+
+    printf("batch   %zu runs on %zu threads, %zu frames in %.2f s, %.0f sim fps\n",
+        report.runs.size(), report.threads, report.frames, report.seconds, report.fps());
+
+    double score = 0, survived = 0;
+    for (const auto& r : report.runs) {
+      printf("run     seed %-4llu score %6d  best combo %3d  %s %7.1f s\n", (unsigned long long)r.seed,
+          r.score, r.best_combo, r.lost ? "died at " : "survived", r.survived);
+      score += r.score;
+      survived += r.survived;
+    }
+
+    const size_t n = std::max<size_t>(report.runs.size(), 1);
+    printf("mean    score %.0f, %.1f s survived\n", score / n, survived / n);
+    if (!determinism) return 0;
+
+    Workers::stop();
+    Workers::start(1);
+    const Batch::Report serial = Batch::run(settings);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < report.runs.size(); ++i) {
+      const Batch::Run& a = report.runs[i];
+      const Batch::Run& b = serial.runs[i];
+      if (a.digest == b.digest && a.frames == b.frames && a.score == b.score) continue;
+      printf("differs seed %-4llu %zu frames %016llx, serial %zu frames %016llx\n", (unsigned long long)a.seed,
+          a.frames, (unsigned long long)a.digest, b.frames, (unsigned long long)b.digest);
+      ++mismatches;
+    }
+    printf("replay  %zu of %zu runs match on 1 thread\n", report.runs.size() - mismatches, report.runs.size());
+    return mismatches == 0 ? 0 : 1;
+  }
+}
+
+int main(int argc, char** argv) {
+  size_t frames = 3600, warmup = 600, budget = 0, threads = 0, runs = 0, title = 60;
+  int autopilot = -1;
+  bool determinism = false;
+  size_t history = 0;
+  const char* telemetry = "";
+  Quality::Settings quality = kConfig.quality;
+
+  for (int i = 1; i < argc; ++i) {
+    if (i + 1 == argc) usage(argv[0]);
+    const size_t value = strtoul(argv[i + 1], nullptr, 10);
+
+    if (strcmp(argv[i], "-f") == 0) frames = value;
+    else if (strcmp(argv[i], "-w") == 0) warmup = value;
+    else if (strcmp(argv[i], "-b") == 0) budget = value;
+    else if (strcmp(argv[i], "-j") == 0) threads = value;
+    else if (strcmp(argv[i], "-r") == 0) quality.target_hz = value;
+    else if (strcmp(argv[i], "-t") == 0) telemetry = argv[i + 1];
+    else if (strcmp(argv[i], "-n") == 0) runs = value;
+    else if (strcmp(argv[i], "-a") == 0) autopilot = value != 0;
+    else if (strcmp(argv[i], "-s") == 0) history = value;
+    else if (strcmp(argv[i], "-T") == 0) title = value;
+    else if (strcmp(argv[i], "-d") == 0) determinism = value != 0;
+    else usage(argv[0]);
+
+    ++i;
+  }
+
+  if (runs > 0) {
+    Workers::start(threads);
+    const int result = batch(runs, frames, autopilot != 0, determinism);
+    Workers::stop();
+    return result;
+  }
+
+  Autopilot::enable(autopilot == 1);
+
+  SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+  SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+  if (SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO) != 0) {
+    fprintf(stderr, "Unable to initialize SDL: %s\n", SDL_GetError());
+    return 1;
+  }
+
+  Workers::start(threads);
+  Quality::configure(quality);
+  Telemetry::start(telemetry, false);
+  Rewind::start(history << 20);
+  const size_t workers = Workers::count();
+
+  Totals totals;
+  std::vector<PoolBudget::Stats> pools;
+  std::string samples;
+  double load_ms = 0, poll_ms = 0, total_ms = 0, worst_ms = 0, draw_ms = 0;
+  Histogram update_times;
+  size_t full = 0, distant = 0, worst_distant = 0;
+  double level = 0, lowest_level = quality.max_level;
+  size_t over_budget = 0;
+  RewindReport history_report = { {}, 0, true };
+
+  {
+    Audio audio;
+    Input input;
+    Graphics graphics(kConfig.graphics);
+
+    // title screen frames at 60 Hz polling the loader the way TitleScreen
+    // does, then whatever starting a game still has to wait for
+    Assets::preload();
+    for (size_t i = 0; i < title; ++i) {
+      const auto poll_start = std::chrono::steady_clock::now();
+      Assets::poll();
+      const auto polled = std::chrono::steady_clock::now();
+      poll_ms = std::max(poll_ms, std::chrono::duration<double, std::milli>(polled - poll_start).count());
+      std::this_thread::sleep_until(poll_start + std::chrono::microseconds(16667));
+    }
+
+    const auto load_start = std::chrono::steady_clock::now();
+    GameScreen screen;
+    load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count();
+    samples = Assets::source();
+
+    for (size_t i = 0; i < frames; ++i) {
+      // discard anything the harness itself allocated between frames
+      Alloc::end_frame();
+
+      const auto start = std::chrono::steady_clock::now();
+      screen.update(input, audio, 16);
+      const auto finish = std::chrono::steady_clock::now();
+
+      // the same calls Game::step makes, so the overlay and every draw
+      // path count against the allocation budget too
+      graphics.clear();
+      screen.draw(graphics);
+      graphics.flip();
+      const auto drawn = std::chrono::steady_clock::now();
+
+      Alloc::end_frame();
+      Quality::end_frame();
+      if (i < warmup) continue;
+
+      const double ms = std::chrono::duration<double, std::milli>(finish - start).count();
+      total_ms += ms;
+      worst_ms = std::max(worst_ms, ms);
+      update_times.add((float)ms);
+      draw_ms += std::chrono::duration<double, std::milli>(drawn - finish).count();
+
+      level += Quality::level();
+      lowest_level = std::min<double>(lowest_level, Quality::level());
+
+      const Simulation::Tiers tiers = screen.tiers();
+      full += tiers.full;
+      distant += tiers.distant;
+      worst_distant = std::max(worst_distant, tiers.distant);
+
+      const Alloc::Frame& frame = Alloc::last_frame();
+      totals.add(frame);
+      if (budget > 0 && frame.total.count > budget) ++over_budget;
+    }
+
+    pools = screen.pools().stats();
+    if (Rewind::active()) history_report = rewind(screen.simulation());
+    Assets::unload();
+  }
+
+  const std::vector<Telemetry::Growth> growing = Telemetry::growing();
+  const Histogram record_times = Rewind::record_times();
+  Telemetry::stop();
+  Rewind::stop();
+  Workers::stop();
+  SDL_Quit();
+
+  const size_t measured = std::max<size_t>(totals.frames, 1);
+  printf("load    %.3f ms to start a game after %zu title frames, %.3f ms worst poll\n", load_ms, title, poll_ms);
+  printf("samples %s\n", samples.c_str());
+  printf("frames  %zu (+%zu warmup)\n", totals.frames, std::min(warmup, frames));
+  printf("threads %zu\n", workers);
+  printf("update  %.3f ms mean, p50 %.1f, p95 %.1f, p99 %.1f, max %.3f ms\n", total_ms / measured,
+      update_times.percentile(0.50f), update_times.percentile(0.95f), update_times.percentile(0.99f), worst_ms);
+  printf("draw    %.3f ms mean\n", draw_ms / measured);
+
+  printf("quality %.2f mean, %.2f min at %.0f Hz\n", level / measured, lowest_level, quality.target_hz);
+  printf("lod     %.1f full, %.1f distant per frame, %zu distant max\n",
+      (double)full / measured, (double)distant / measured, worst_distant);
+
+  printf("pools   %-16s %8s %8s %8s %8s %10s\n", "", "size", "peak", "baseline", "capacity", "bytes");
+  for (const auto& p : pools) {
+    printf("        %-16s %8zu %8zu %8zu %8zu %10zu\n", p.name, p.size, p.peak, p.baseline, p.capacity, p.bytes);
+  }
+
+  if (history > 0) {
+    const Rewind::Stats& r = history_report.stats;
+    printf("rewind  %zu frames in %.1f MiB, %zu bytes a frame raw, %.0f encoded\n", r.frames,
+        r.bytes / 1048576.0, r.raw, (double)r.bytes / std::max<size_t>(r.frames, 1));
+    printf("record  p50 %.1f, p95 %.1f, p99 %.1f, max %.3f ms\n", record_times.percentile(0.50f),
+        record_times.percentile(0.95f), record_times.percentile(0.99f), record_times.max());
+    printf("restore %.3f ms for the oldest frame, latest frame %s\n",
+        history_report.restore_ms, history_report.matches ? "matches" : "differs");
+  }
+
+  for (const auto& g : growing) printf("growth  %s floor rose from %zu to %zu\n", g.name, g.from, g.to);
+
+  if (Alloc::tracking()) {
+    printf("allocs  %.1f per frame, %.0f bytes per frame, %zu max\n",
+        (double)totals.total.count / measured, (double)totals.total.bytes / measured, totals.worst);
+
+    std::sort(totals.scopes.begin(), totals.scopes.begin() + totals.scope_count,
+        [](const Alloc::Entry& a, const Alloc::Entry& b) { return a.stats.count > b.stats.count; });
+    for (size_t i = 0; i < totals.scope_count; ++i) {
+      const Alloc::Entry& e = totals.scopes[i];
+      printf("  %-32s %10.2f allocs %12.0f bytes per frame\n",
+          e.name, (double)e.stats.count / measured, (double)e.stats.bytes / measured);
+    }
+
+    if (budget > 0) {
+      printf("budget  %zu allocs per frame, %zu frames over\n", budget, over_budget);
+      if (over_budget > 0) return 1;
+    }
+  } else if (budget > 0) {
+    fprintf(stderr, "allocation budget needs an instrumented build (make PROFILE=1)\n");
+    return 2;
+  }
+
+  return growing.empty() && history_report.matches ? 0 : 1;
+}
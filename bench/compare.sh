@@ -0,0 +1,42 @@
+#!/bin/bash
+# Builds bench at another revision in a scratch worktree, then runs it and
+# the working tree's bench with the same arguments for before and after
+# numbers.  Run it twice or more, a loaded machine swings a lot.
+#
+#   bench/compare.sh <revision> [bench arguments]
+
+set -e
+
+if [ $# -lt 1 ]; then
+  echo "usage: $0 revision [bench arguments]" >&2
+  exit 2
+fi
+
+rev="$1"
+shift
+
+root="$(git rev-parse --show-toplevel)"
+
+# numbers from anything but the pinned gam and EnTT don't say much about
+# the game, so refuse to run without them
+for module in gam entt; do
+  if [ -z "$(ls -A "$root/$module" 2>/dev/null)" ]; then
+    echo "$0: $module isn't checked out, run git submodule update --init" >&2
+    exit 1
+  fi
+done
+
+tree="$(mktemp -d)"
+trap 'git -C "$root" worktree remove --force "$tree"' EXIT
+
+git -C "$root" worktree add -q --detach "$tree" "$rev"
+git -C "$tree" submodule -q update --init
+make -C "$tree" -s output/bench
+make -C "$root" -s output/bench
+
+echo "before: $rev"
+git -C "$tree" submodule status
+"$tree/output/bench" "$@"
+echo "after: working tree"
+git -C "$root" submodule status
+"$root/output/bench" "$@"
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "geometry.h"
+#include "shapes.h"
 
 struct Health { int health = 20; };
 
@@ -27,13 +28,14 @@ struct Bomb { bool active = true; float time = 5.0f; };
 struct Blast { float rad = 0.1f, fade = 1.5f; };
 struct Firing { float rate = 0.175f, spread = 0.0f, time = rate; };
 struct ScreenWrap {};
-struct Polygon { polygon poly; };
+struct Polygon { Shapes::Handle shape; float scale = 1.0f; };
 
+// started on the game clock, expiry is driven by Simulation's timer wheel
 struct Timer {
   float lifetime = 1.0f;
   bool expire = true;
-  float elapsed = 0.0f;
-  constexpr float ratio() const { return elapsed / lifetime; };
+  float start = 0.0f;
+  constexpr float ratio(float now) const { return (now - start) / lifetime; };
 };
 
 struct FadeOut {};
@@ -46,4 +48,16 @@ struct KillOffScreen {};
 struct BounceWalls {};
 struct ReturnToField {};
 struct SeekPlayer { float range = 25.0f; };
-struct Flocking {};
+struct Flocking { entt::entity squad; };
+
+// drones spawned together and steered as one flock, the totals are redone
+// every frame from the members on the field
+struct Squad {
+  uint32_t size = 0, spawned = 0;
+  uint32_t alive = 0, active = 0;
+  pos center = {}, heading = {}, steer = {};
+  pos lo = {}, hi = {};
+};
+
+// far outside the screen, flies straight in without neighbor or collision work
+struct Distant {};
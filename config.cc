@@ -6,4 +6,8 @@ Config::Config() : Game::Config() {
   graphics.height = 720;
   graphics.intscale = false;
   graphics.fullscreen = false;
+
+  quality.target_hz = 60.0f;
+  quality.min_level = 0.25f;
+  quality.max_level = 1.0f;
 }
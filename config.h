@@ -2,5 +2,10 @@
 
 #include "game.h"
 
-struct Config : public Game::Config { Config(); };
+#include "quality.h"
+
+struct Config : public Game::Config {
+  Config();
+  Quality::Settings quality;
+};
 static const Config kConfig;
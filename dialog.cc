@@ -2,10 +2,13 @@
 
 #include <sstream>
 
+#include "assets.h"
 #include "config.h"
 
+using namespace entt::literals;
+
 Dialog::Dialog() :
-  text_("text.png", 16),
+  text_(Assets::text("text.png"_hs)),
   message_(""), timer_(0), index_(0) {}
 
 void Dialog::set_message(const std::string& message) {
@@ -21,7 +21,7 @@ class Dialog {
 
     static constexpr float kRate = 0.075f;
 
-    Text text_;
+    const Text& text_;
     std::string message_;
     float  timer_;
     size_t index_;
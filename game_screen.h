@@ -1,13 +1,14 @@
 #pragma once
 
-#include <random>
-
 #include "entt/entity/registry.hpp"
 
 #include "screen.h"
 #include "text.h"
 
-#include "geometry.h"
+#include "pool_budget.h"
+#include "resolution.h"
+#include "simulation.h"
+#include "sound_queue.h"
 
 class GameScreen : public Screen {
   public:
@@ -20,53 +21,29 @@ class GameScreen : public Screen {
     Screen* next_screen() const override;
     std::string get_music_track() const override { return "battle.ogg"; }
 
-  private:
-
-    enum class state { playing, paused, lost };
-
-    entt::registry reg_;
-    std::mt19937 rng_;
-    Text text_;
-
-    state state_;
-    int score_, combo_, best_combo_;
-    int bombs_;
-    float bomb_cooldown_;
-    float spawns_, spawn_timer_;
-    float roid_timer_;
+    const Simulation& simulation() const { return sim_; }
+    const PoolBudget& pools() const { return sim_.pools(); }
+    Simulation::Tiers tiers() const { return sim_.tiers(); }
 
-    void user_input(const Input& input, Audio& audio);
-
-    void collision(Audio& audio);
-
-    void acceleration(float t);
-    void rotation(float t);
-    void spin(float t);
-    void steering(float t);
-    void flocking();
-    void seek_player();
-    void return_to_field();
-    void bounce_walls();
-    void max_velocity();
-    void movement(float t);
+  private:
 
-    void expiring(float t);
-    void firing(Audio& audio, float t);
-    void bombs(Audio& audio, float t);
+    Simulation sim_;
+    // the simulation's registry, only read here to draw it
+    const entt::registry& reg_;
+    const Text& text_;
+    mutable Resolution resolution_;
+    SoundQueue sounds_;
+    // frames back from the latest while paused and looking through the
+    // rewind history
+    size_t back_;
 
-    void kill_dead(Audio& audio);
-    void kill_oob();
+    void seek(size_t back);
 
     void draw_flash(Graphics& graphics) const;
     void draw_polys(Graphics& graphics) const;
     void draw_bullets(Graphics& graphics) const;
     void draw_particles(Graphics& graphics) const;
     void draw_bombs(Graphics& graphics) const;
+    void draw_fills(Graphics& graphics) const;
     void draw_overlay(Graphics& graphics) const;
-
-    void spawn_drones(size_t count, float distance);
-    void spawn_saucer(float distance);
-    void spawn_asteroid(float distance);
-    entt::entity spawn_asteroid_at(pos p, float size);
-    void explosion(const pos& p, uint32_t color);
 };
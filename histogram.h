@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+// Fixed bin histogram of durations in milliseconds.  Adding a sample is an
+// increment, so it can run every frame or every input event without
+// allocating, and percentiles are read back to the bin width.
+class Histogram {
+  public:
+
+    static constexpr float kBinMs = 0.1f;
+    static constexpr size_t kBins = 2000;
+
+    void add(float ms) {
+      ++bins_[bin(ms)];
+      ++count_;
+      max_ = std::max(max_, ms);
+    }
+
+    // takes back a sample added earlier, for rolling windows; max() keeps
+    // the largest sample since the last clear
+    void remove(float ms) {
+      --bins_[bin(ms)];
+      --count_;
+    }
+
+    // upper edge of the bin holding the p'th sample, p in [0, 1]
+    float percentile(float p) const {
+      if (count_ == 0) return 0;
+      const size_t rank = std::max<size_t>(1, (size_t)(p * count_ + 0.5f));
+      size_t seen = 0;
+      for (size_t i = 0; i < kBins; ++i) {
+        seen += bins_[i];
+        if (seen >= rank) return std::min(max_, (i + 1) * kBinMs);
+      }
+      return max_;
+    }
+
+    size_t count() const { return count_; }
+    float max() const { return max_; }
+
+    void clear() {
+      bins_.fill(0);
+      count_ = 0;
+      max_ = 0;
+    }
+
+  private:
+
+    static size_t bin(float ms) {
+      return ms <= 0 ? 0 : std::min(kBins - 1, (size_t)(ms / kBinMs));
+    }
+
+    std::array<size_t, kBins> bins_ = {};
+    size_t count_ = 0;
+    float max_ = 0;
+};
@@ -0,0 +1,104 @@
+#include "latency.h"
+
+#include <SDL2/SDL.h>
+
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "histogram.h"
+#include "quality.h"
+#include "trace.h"
+
+namespace {
+  // the watch can be called from whichever thread pushes the event
+  std::mutex mutex;
+  std::vector<Uint64> pending;
+
+  Histogram histogram;
+  bool started = false;
+  Uint64 last_present = 0;
+
+  float ms_between(Uint64 from, Uint64 to) {
+    return (float)((double)(to - from) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+  }
+
+  int watch(void*, SDL_Event* event) {
+    bool press = false;
+    switch (event->type) {
+      case SDL_KEYDOWN:
+        press = !event->key.repeat;
+        break;
+      case SDL_MOUSEBUTTONDOWN:
+      case SDL_JOYBUTTONDOWN:
+      case SDL_CONTROLLERBUTTONDOWN:
+        press = true;
+        break;
+    }
+
+    if (press) {
+      const std::lock_guard<std::mutex> lock(mutex);
+      pending.push_back(SDL_GetPerformanceCounter());
+    }
+    return 1;
+  }
+}
+
+void Latency::start() {
+  if (started) return;
+  pending.reserve(64);
+  histogram.clear();
+  SDL_AddEventWatch(watch, nullptr);
+  started = true;
+}
+
+void Latency::stop() {
+  if (!started) return;
+  SDL_DelEventWatch(watch, nullptr);
+  started = false;
+
+  const Report r = report();
+  if (r.samples == 0) return;
+  fprintf(stderr, "input latency, %zu presses: p50 %.1f ms, p95 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+      r.samples, r.p50, r.p95, r.p99, r.max);
+}
+
+void Latency::presented() {
+  last_present = SDL_GetPerformanceCounter();
+  if (!started) return;
+
+  const std::lock_guard<std::mutex> lock(mutex);
+  for (const auto stamp : pending) {
+    const float ms = ms_between(stamp, last_present);
+    histogram.add(ms);
+    Trace::counter("input latency us", (int64_t)(ms * 1000));
+  }
+  pending.clear();
+}
+
+Latency::Report Latency::report() {
+  return {
+    histogram.count(),
+    histogram.percentile(0.50f),
+    histogram.percentile(0.95f),
+    histogram.percentile(0.99f),
+    histogram.max(),
+  };
+}
+
+void Latency::latch(float period_ms, float margin_ms) {
+  if (last_present == 0) return;
+
+  const float wait = period_ms - Quality::work_ms() - margin_ms;
+  const Uint64 now = SDL_GetPerformanceCounter();
+  const float waited = ms_between(last_present, now);
+  if (wait <= waited) return;
+
+  TRACE_SCOPE("Latency::latch");
+
+  // SDL_Delay only promises at least the time asked for, sleep most of the
+  // way and spin the rest
+  const float remaining = wait - waited;
+  if (remaining > 2.0f) SDL_Delay((Uint32)(remaining - 2.0f));
+  while (ms_between(last_present, SDL_GetPerformanceCounter()) < wait) {}
+}
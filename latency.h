@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+// Input to display latency.  An SDL event watch stamps every key and button
+// press as it is pumped, and the present at the end of the same Game::step
+// closes the sample, since gam reads all pending events at the start of a
+// step and shows the result at the end of it.  The time an event spends in
+// the OS queue before the pump isn't visible to SDL and isn't counted.
+//
+// Late latching delays the start of each step so input is sampled as close
+// to the next present as the measured frame work allows, rather than right
+// after the previous present.
+namespace Latency {
+  struct Report {
+    size_t samples;
+    float p50, p95, p99, max;
+  };
+
+  void start();
+  // prints the report to stderr when there were any samples
+  void stop();
+
+  // call after every Game::step
+  void presented();
+  Report report();
+
+  // sleeps until margin_ms plus the expected frame work before the next
+  // refresh, period_ms after the last present
+  void latch(float period_ms, float margin_ms);
+}
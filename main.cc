@@ -1,25 +1,104 @@
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <cstdlib>
+
 #include "game.h"
 
+#include "alloc.h"
+#include "assets.h"
+#include "autopilot.h"
 #include "config.h"
+#include "latency.h"
+#include "pacing.h"
+#include "quality.h"
+#include "rewind.h"
+#include "telemetry.h"
 #include "title_screen.h"
+#include "trace.h"
+#include "workers.h"
 
 #ifdef __EMSCRIPTEN__
 #include "emscripten.h"
 
 void step(void* game) {
-  static_cast<Game*>(game)->step();
+  {
+    TRACE_SCOPE("Game::step");
+    static_cast<Game*>(game)->step();
+  }
+  Latency::presented();
+  Alloc::end_frame();
+  Quality::end_frame();
+  Pacing::end_frame();
 }
 #endif
 
 int main(int, char**) {
+  const char* trace = std::getenv("HYDRA_TRACE");
+  if (trace) Trace::start(trace);
+
   Game game(kConfig);
+  Quality::configure(kConfig.quality);
+  Assets::preload();
+  // threads up before the first frame rather than in the middle of one
+  Workers::start();
+
+  // HYDRA_LATENCY reports input to present latency on exit
+  if (std::getenv("HYDRA_LATENCY")) Latency::start();
+
+  // HYDRA_JANK=path logs every frame over budget and reports pacing on exit
+  const char* jank = std::getenv("HYDRA_JANK");
+  Pacing::start(jank ? jank : "", kConfig.quality.target_hz);
+
+  // HYDRA_POOLS=path samples pool sizes to a CSV file and reports growth on
+  // exit, HYDRA_POOLS_OVERLAY shows the busiest pools in game
+  const char* pools = std::getenv("HYDRA_POOLS");
+  Telemetry::start(pools ? pools : "", std::getenv("HYDRA_POOLS_OVERLAY") != nullptr);
+
+  // HYDRA_AUTOPILOT flies the ship, for combat heavy profiling sessions
+  Autopilot::enable(std::getenv("HYDRA_AUTOPILOT") != nullptr);
+
+  // HYDRA_REWIND=MiB keeps that much game history, left and right step
+  // through it while paused
+  const char* rewind = std::getenv("HYDRA_REWIND");
+  if (rewind) Rewind::start((size_t)std::max(1, std::atoi(rewind)) << 20);
+
   Screen *start = new TitleScreen();
 
 #ifdef __EMSCRIPTEN__
   game.start(start);
   emscripten_set_main_loop_arg(step, &game, 0, true);
 #else
-  game.loop(start);
+  // HYDRA_LATE_LATCH=ms delays each step so input is read that long plus the
+  // expected frame work before the next refresh
+  const char* latch = std::getenv("HYDRA_LATE_LATCH");
+  const float latch_margin = latch ? std::max(1.0f, (float)std::atof(latch)) : 0.0f;
+
+  SDL_DisplayMode mode;
+  const float period = SDL_GetCurrentDisplayMode(0, &mode) == 0 && mode.refresh_rate > 0 ?
+    1000.0f / mode.refresh_rate : 1000.0f / kConfig.quality.target_hz;
+
+  game.start(start);
+  while (true) {
+    {
+      TRACE_SCOPE("Game::step");
+      if (!game.step()) break;
+    }
+    Latency::presented();
+    Alloc::end_frame();
+    Quality::end_frame();
+    Pacing::end_frame();
+
+    if (latch) Latency::latch(period, latch_margin);
+  }
+
+  Latency::stop();
+  Pacing::stop();
+  Telemetry::stop();
+  Rewind::stop();
+  Assets::unload();
+  Workers::stop();
+  Trace::stop();
 #endif
 
   return 0;
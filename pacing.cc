@@ -0,0 +1,138 @@
+#include "pacing.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+
+#include "histogram.h"
+#include "quality.h"
+#include "trace.h"
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  // about ten seconds at 60 Hz
+  constexpr size_t kWindow = 600;
+  // a frame that misses vsync shows up as a double length frame, the slack
+  // keeps ordinary timer jitter out of the log
+  constexpr float kJankSlack = 1.2f;
+
+  class Series {
+    public:
+
+      void add(float ms) {
+        if (filled_ == kWindow) histogram_.remove(ring_[next_]);
+        else ++filled_;
+
+        ring_[next_] = ms;
+        next_ = (next_ + 1) % kWindow;
+        histogram_.add(ms);
+        session_.add(ms);
+      }
+
+      Pacing::Stats stats() const {
+        const float max = filled_ ? *std::max_element(ring_.begin(), ring_.begin() + filled_) : 0.0f;
+        return { histogram_.percentile(0.50f), histogram_.percentile(0.95f), histogram_.percentile(0.99f), max };
+      }
+
+      const Histogram& session() const { return session_; }
+
+    private:
+
+      std::array<float, kWindow> ring_ = {};
+      size_t next_ = 0, filled_ = 0;
+      Histogram histogram_, session_;
+  };
+
+  Series frames, updates, draws;
+
+  FILE* jank_log = nullptr;
+  float budget_ms = 1000.0f / 60.0f;
+  bool started = false, report = false;
+  Clock::time_point begin, last;
+  size_t frame_count = 0, jank_count = 0;
+  Pacing::Snapshot latest = { 0, 0, 0, 0, "none" };
+
+  void print(const char* name, const Histogram& h) {
+    fprintf(stderr, "  %-6s p50 %.1f ms, p95 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+        name, h.percentile(0.50f), h.percentile(0.95f), h.percentile(0.99f), h.max());
+  }
+}
+
+void Pacing::start(const std::string& jank_path, float target_hz) {
+  if (started) return;
+
+  budget_ms = 1000.0f / target_hz;
+  report = !jank_path.empty();
+  if (report) {
+    jank_log = fopen(jank_path.c_str(), "w");
+    if (jank_log) fprintf(jank_log, "time_ms,frame_ms,update_ms,draw_ms,entities,particles,bullets,blasts,state\n");
+  }
+
+  begin = last = Clock::now();
+  started = true;
+}
+
+void Pacing::stop() {
+  if (!started) return;
+  started = false;
+
+  if (jank_log) {
+    fclose(jank_log);
+    jank_log = nullptr;
+  }
+
+  if (!report) return;
+  fprintf(stderr, "frame pacing, %zu frames, %zu over %.1f ms:\n", frame_count, jank_count, budget_ms);
+  print("frame", frames.session());
+  print("update", updates.session());
+  print("draw", draws.session());
+}
+
+void Pacing::snapshot(const Snapshot& snapshot) {
+  latest = snapshot;
+}
+
+void Pacing::end_frame() {
+  if (!started) return;
+
+  const auto now = Clock::now();
+  const float frame_ms = std::chrono::duration<float, std::milli>(now - last).count();
+  const float update_ms = Quality::last_ms(Quality::Phase::update);
+  const float draw_ms = Quality::last_ms(Quality::Phase::draw);
+  last = now;
+  ++frame_count;
+
+  frames.add(frame_ms);
+  updates.add(update_ms);
+  draws.add(draw_ms);
+
+  if (frame_ms > budget_ms * kJankSlack) {
+    ++jank_count;
+    if (jank_log) {
+      fprintf(jank_log, "%.0f,%.2f,%.2f,%.2f,%zu,%zu,%zu,%zu,%s\n",
+          std::chrono::duration<double, std::milli>(now - begin).count(),
+          frame_ms, update_ms, draw_ms,
+          latest.entities, latest.particles, latest.bullets, latest.blasts, latest.state);
+    }
+  }
+
+  if (frame_count % 60 == 0) {
+    const Stats s = frames.stats();
+    Trace::counter("frame p95 us", (int64_t)(s.p95 * 1000));
+    Trace::counter("frame p99 us", (int64_t)(s.p99 * 1000));
+  }
+}
+
+Pacing::Stats Pacing::frame() {
+  return frames.stats();
+}
+
+Pacing::Stats Pacing::update() {
+  return updates.stats();
+}
+
+Pacing::Stats Pacing::draw() {
+  return draws.stats();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Frame pacing statistics.  Frame, update and draw times go into rolling
+// histograms over the last few seconds so percentiles show stutter that an
+// average hides.  With a jank log open, every frame over budget is appended
+// as one CSV line together with the latest gameplay snapshot, so a hitch
+// can be matched to what was happening on screen.
+namespace Pacing {
+  struct Snapshot {
+    size_t entities, particles, bullets, blasts;
+    const char* state;
+  };
+
+  struct Stats {
+    float p50, p95, p99, max;
+  };
+
+  // an empty path collects the statistics without a log or a summary
+  void start(const std::string& jank_path, float target_hz);
+  // closes the log and prints the session percentiles to stderr
+  void stop();
+
+  // recorded with any jank entry until the next snapshot
+  void snapshot(const Snapshot& snapshot);
+
+  // call after every Game::step, once Quality has closed the frame
+  void end_frame();
+
+  Stats frame();
+  Stats update();
+  Stats draw();
+}
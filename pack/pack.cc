@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "archive.h"
+
+// Packs content files into a single archive for Archive to map.
+//
+//   pack output.pak file...
+//
+// Entries are keyed by the hashed base name, so content/boom0.wav is found
+// with "boom0.wav"_hs just like the loose file would be.
+
+namespace {
+  struct File {
+    std::string name;
+    entt::id_type hash;
+    std::vector<char> data;
+  };
+
+  size_t align(size_t n) {
+    return (n + Archive::kAlignment - 1) / Archive::kAlignment * Archive::kAlignment;
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s output.pak file...\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<File> files;
+  for (int i = 2; i < argc; ++i) {
+    const std::string path = argv[i];
+    const size_t slash = path.find_last_of("/\\");
+    const std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+
+    if (name.size() >= sizeof(Archive::Entry::name)) {
+      fprintf(stderr, "%s: name too long for the index\n", path.c_str());
+      return 1;
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+      fprintf(stderr, "%s: unable to read\n", path.c_str());
+      return 1;
+    }
+
+    files.push_back({ name, entt::hashed_string::value(name.c_str()),
+        std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()) });
+  }
+
+  std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.hash < b.hash; });
+  for (size_t i = 1; i < files.size(); ++i) {
+    if (files[i - 1].hash == files[i].hash) {
+      fprintf(stderr, "%s and %s have the same hash\n", files[i - 1].name.c_str(), files[i].name.c_str());
+      return 1;
+    }
+  }
+
+  Archive::Header header = {};
+  std::memcpy(header.magic, Archive::kMagic, sizeof(header.magic));
+  header.version = Archive::kVersion;
+  header.count = (uint32_t)files.size();
+
+  std::vector<Archive::Entry> index;
+  size_t offset = align(sizeof(header) + files.size() * sizeof(Archive::Entry));
+  for (const auto& f : files) {
+    Archive::Entry e = {};
+    e.hash = f.hash;
+    e.offset = (uint32_t)offset;
+    e.size = (uint32_t)f.data.size();
+    std::strncpy(e.name, f.name.c_str(), sizeof(e.name) - 1);
+    index.push_back(e);
+    offset = align(offset + f.data.size());
+  }
+
+  std::ofstream out(argv[1], std::ios::binary);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(Archive::Entry));
+
+  for (size_t i = 0; i < files.size(); ++i) {
+    const auto& f = files[i];
+    const size_t padding = index[i].offset - (size_t)out.tellp();
+    out.write(std::string(padding, '\0').data(), padding);
+    out.write(f.data.data(), f.data.size());
+  }
+
+  if (!out) {
+    fprintf(stderr, "%s: unable to write\n", argv[1]);
+    return 1;
+  }
+
+  return 0;
+}
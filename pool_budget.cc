@@ -0,0 +1,113 @@
+#include "pool_budget.h"
+
+#include <type_traits>
+
+#include "components.h"
+#include "trace.h"
+
+namespace {
+  template <typename T> struct type { using value = T; };
+
+  // Baselines are the peaks bench printed for the first two minutes of
+  // ordinary play, "bench -f 7200 -a 1" with the autopilot flying the
+  // default seed, rounded up to a power of two.  Pools that run never
+  // touched, like bombs, get 4.  Re-measure when spawn rates change.
+  template <typename F> void each_pool(F f) {
+    f(type<Position>{},       "Position",       8192);
+    f(type<Velocity>{},       "Velocity",       8192);
+    f(type<Angle>{},          "Angle",          8192);
+    f(type<Color>{},          "Color",          8192);
+    f(type<Timer>{},          "Timer",          8192);
+    f(type<Particle>{},       "Particle",       8192);
+    f(type<BounceWalls>{},    "BounceWalls",    8192);
+    f(type<Bullet>{},         "Bullet",         32);
+    f(type<KillOffScreen>{},  "KillOffScreen",  32);
+    f(type<MaxVelocity>{},    "MaxVelocity",    128);
+    f(type<Collision>{},      "Collision",      128);
+    f(type<Health>{},         "Health",         128);
+    f(type<Polygon>{},        "Polygon",        128);
+    f(type<TargetDir>{},      "TargetDir",      128);
+    f(type<SeekPlayer>{},     "SeekPlayer",     128);
+    f(type<ReturnToField>{},  "ReturnToField",  128);
+    f(type<Flocking>{},       "Flocking",       128);
+    f(type<Squad>{},          "Squad",          32);
+    f(type<Distant>{},        "Distant",        64);
+    f(type<Firing>{},         "Firing",         8);
+    f(type<Spin>{},           "Spin",           16);
+    f(type<Crumble>{},        "Crumble",        8);
+    f(type<ScreenWrap>{},     "ScreenWrap",     16);
+    f(type<Bump>{},           "Bump",           32);
+    f(type<Flash>{},          "Flash",          1);
+    f(type<KilledByPlayer>{}, "KilledByPlayer", 4);
+    f(type<Acceleration>{},   "Acceleration",   1);
+    f(type<Rotation>{},       "Rotation",       1);
+    f(type<Bomb>{},           "Bomb",           4);
+    f(type<Blast>{},          "Blast",          4);
+    f(type<FadeOut>{},        "FadeOut",        4);
+    f(type<PlayerControl>{},  "PlayerControl",  1);
+  }
+
+  // dense entity array plus the components themselves, sparse pages aren't counted
+  template <typename T> size_t pool_bytes(size_t capacity) {
+    return capacity * (sizeof(entt::entity) + (std::is_empty_v<T> ? 0 : sizeof(T)));
+  }
+}
+
+PoolBudget::PoolBudget(entt::registry& reg) : reg_(reg), quiet_(0) {
+  TRACE_SCOPE("PoolBudget::PoolBudget");
+  each_pool([this](auto t, const char* name, size_t baseline) {
+    using T = typename decltype(t)::value;
+    auto& pool = reg_.storage<T>();
+    pool.reserve(baseline);
+    stats_.push_back({ name, pool.size(), pool.size(), pool.capacity(), pool_bytes<T>(pool.capacity()), baseline });
+  });
+}
+
+void PoolBudget::update(float t) {
+  TRACE_SCOPE("PoolBudget::update");
+
+  bool over = false, busy = false;
+  size_t i = 0;
+  each_pool([&](auto tag, const char*, size_t) {
+    using T = typename decltype(tag)::value;
+    const auto& pool = reg_.storage<T>();
+    Stats& s = stats_[i++];
+
+    s.size = pool.size();
+    s.capacity = pool.capacity();
+    s.bytes = pool_bytes<T>(s.capacity);
+    if (s.size > s.peak) s.peak = s.size;
+
+    if (s.capacity > 2 * s.baseline) over = true;
+    if (s.size > s.baseline) busy = true;
+  });
+
+  quiet_ = busy ? 0.0f : quiet_ + t;
+  if (over && quiet_ > kQuietTime) compact();
+
+  Trace::counter("pool bytes", bytes());
+}
+
+size_t PoolBudget::bytes() const {
+  size_t total = 0;
+  for (const auto& s : stats_) total += s.bytes;
+  return total;
+}
+
+void PoolBudget::compact() {
+  TRACE_SCOPE("PoolBudget::compact");
+
+  size_t i = 0;
+  each_pool([&](auto tag, const char*, size_t) {
+    using T = typename decltype(tag)::value;
+    auto& pool = reg_.storage<T>();
+    Stats& s = stats_[i++];
+
+    if (pool.capacity() > 2 * s.baseline) {
+      pool.shrink_to_fit();
+      pool.reserve(s.baseline);
+      s.capacity = pool.capacity();
+      s.bytes = pool_bytes<T>(s.capacity);
+    }
+  });
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "entt/entity/registry.hpp"
+
+// Capacity policy for the component pools of a registry.  Every pool is
+// reserved up front for its usual working set so a swarm or a chain of
+// explosions doesn't reallocate mid fight.  Pools that grew well past that
+// during a spike are compacted back once the game has been quiet for a
+// while, so memory stays bounded.
+class PoolBudget {
+  public:
+
+    struct Stats {
+      const char* name;
+      size_t size, peak, capacity, bytes, baseline;
+    };
+
+    explicit PoolBudget(entt::registry& reg);
+
+    // tracks high water marks and compacts when quiet, call once per frame
+    void update(float t);
+
+    const std::vector<Stats>& stats() const { return stats_; }
+    size_t bytes() const;
+
+  private:
+
+    static constexpr float kQuietTime = 3.0f;
+
+    entt::registry& reg_;
+    std::vector<Stats> stats_;
+    float quiet_;
+
+    void compact();
+};
@@ -0,0 +1,83 @@
+#include "quality.h"
+
+#include <algorithm>
+
+#include "trace.h"
+
+namespace {
+  constexpr float kStep = 0.25f;
+  constexpr float kSmoothing = 0.1f;
+
+  // drop after a quarter second near the budget, raise after two seconds
+  // comfortably under it
+  constexpr float kDropAt = 0.9f;
+  constexpr float kRaiseAt = 0.6f;
+  constexpr int kDropFrames = 15;
+  constexpr int kRaiseFrames = 120;
+
+  Quality::Settings settings;
+  float current = 1.0f;
+  double frame_ms[2] = {};
+  float last[2] = {};
+  float average = 0;
+  int over = 0, under = 0;
+}
+
+void Quality::configure(const Settings& s) {
+  settings = s;
+  // effect counts are sized for full quality, the level never scales past it
+  settings.max_level = std::min(settings.max_level, 1.0f);
+  settings.min_level = std::min(settings.min_level, settings.max_level);
+  current = std::clamp(current, settings.min_level, settings.max_level);
+}
+
+void Quality::end_frame() {
+  const float budget = 1000.0f / settings.target_hz;
+  for (size_t i = 0; i < 2; ++i) {
+    last[i] = (float)frame_ms[i];
+    frame_ms[i] = 0;
+  }
+  average += (last[0] + last[1] - average) * kSmoothing;
+
+  if (average > budget * kDropAt) {
+    under = 0;
+    if (++over >= kDropFrames) {
+      current = std::max(settings.min_level, current - kStep);
+      over = 0;
+    }
+  } else if (average < budget * kRaiseAt) {
+    over = 0;
+    if (++under >= kRaiseFrames) {
+      current = std::min(settings.max_level, current + kStep);
+      under = 0;
+    }
+  } else {
+    over = under = 0;
+  }
+
+  Trace::counter("quality", (int64_t)(current * 100));
+}
+
+float Quality::level() {
+  return current;
+}
+
+float Quality::work_ms() {
+  return average;
+}
+
+float Quality::last_ms(Phase phase) {
+  return last[(size_t)phase];
+}
+
+size_t Quality::scale(size_t count) {
+  return std::max<size_t>(1, (size_t)(count * current));
+}
+
+float Quality::lifetime(float seconds) {
+  return seconds * (0.5f + 0.5f * current);
+}
+
+Quality::Work::~Work() {
+  frame_ms[(size_t)phase_] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+}
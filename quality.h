@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+// Governor for the cost of cosmetic effects.  Screens mark the time they
+// spend updating and drawing with Quality::Work, and once per frame the
+// total is compared against the budget for the target frame rate.  The
+// level drops a step when the smoothed work time stays near the budget and
+// only climbs back after a long stretch well under it, so one heavy frame
+// doesn't make the effects flicker.
+namespace Quality {
+  enum class Phase { update, draw };
+
+  struct Settings {
+    float target_hz = 60.0f;
+    // max_level is capped at 1
+    float min_level = 0.25f, max_level = 1.0f;
+  };
+
+  void configure(const Settings& settings);
+  void end_frame();
+
+  // current level in [min_level, max_level], 1 is full quality
+  float level();
+  // smoothed time spent in Work scopes per frame
+  float work_ms();
+  // time spent in one phase during the last finished frame
+  float last_ms(Phase phase);
+
+  // count scaled by the level, never below one
+  size_t scale(size_t count);
+  // lifetimes shrink half as fast as counts
+  float lifetime(float seconds);
+
+  class Work {
+    public:
+      explicit Work(Phase phase) : phase_(phase), start_(std::chrono::steady_clock::now()) {}
+      ~Work();
+
+      Work(const Work&) = delete;
+      Work& operator=(const Work&) = delete;
+
+    private:
+      Phase phase_;
+      std::chrono::steady_clock::time_point start_;
+  };
+}
@@ -0,0 +1,79 @@
+#include "resolution.h"
+
+#include <SDL2/SDL.h>
+
+#include <string>
+
+#include "quality.h"
+#include "trace.h"
+
+namespace {
+  // gam owns the window and doesn't hand out its renderer
+  SDL_Renderer* find_renderer() {
+    for (Uint32 id = 1; id < 8; ++id) {
+      SDL_Window* window = SDL_GetWindowFromID(id);
+      SDL_Renderer* renderer = window ? SDL_GetRenderer(window) : nullptr;
+      if (renderer) return renderer;
+    }
+    return nullptr;
+  }
+}
+
+Resolution::Resolution(const Graphics::Config& config) :
+  width_(config.width), height_(config.height), intscale_(config.intscale),
+  renderer_(nullptr), target_(nullptr),
+  unsupported_(false), active_(false),
+  scale_(1.0f) {}
+
+Resolution::~Resolution() {
+  if (target_) SDL_DestroyTexture(target_);
+}
+
+void Resolution::begin() {
+  const float level = Quality::level();
+  scale_ = intscale_ ? (level > 0.5f ? 1.0f : 0.5f) : 0.5f + 0.5f * level;
+  if (scale_ < 1.0f && !create()) scale_ = 1.0f;
+
+  Trace::counter("render scale %", (int64_t)(scale_ * 100));
+  if (scale_ >= 1.0f) return;
+
+  TRACE_SCOPE("Resolution::begin");
+  SDL_SetRenderTarget(renderer_, target_);
+  SDL_RenderSetScale(renderer_, scale_, scale_);
+  SDL_SetRenderDrawColor(renderer_, 0, 0, 0, 255);
+  SDL_RenderClear(renderer_);
+  active_ = true;
+}
+
+void Resolution::end() {
+  if (!active_) return;
+  active_ = false;
+
+  TRACE_SCOPE("Resolution::end");
+  SDL_SetRenderTarget(renderer_, nullptr);
+
+  const SDL_Rect used = { 0, 0, (int)(width_ * scale_), (int)(height_ * scale_) };
+  SDL_RenderCopy(renderer_, target_, &used, nullptr);
+}
+
+bool Resolution::create() {
+  if (target_) return true;
+  if (unsupported_) return false;
+
+  renderer_ = find_renderer();
+  if (!renderer_ || !SDL_RenderTargetSupported(renderer_)) {
+    unsupported_ = true;
+    return false;
+  }
+
+  // the filter is picked up when a texture is created, leave it as it was
+  // for anything gam loads later
+  const char* previous = SDL_GetHint(SDL_HINT_RENDER_SCALE_QUALITY);
+  const std::string restore = previous ? previous : "nearest";
+  SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, intscale_ ? "nearest" : "linear");
+  target_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width_, height_);
+  SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, restore.c_str());
+
+  unsupported_ = target_ == nullptr;
+  return target_ != nullptr;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "graphics.h"
+
+struct SDL_Renderer;
+struct SDL_Texture;
+
+// Offscreen render target for the world pass.  While the quality governor
+// has headroom the world is drawn straight to the screen; when it starts
+// shedding work the world is drawn into a smaller part of this target and
+// stretched back up, which cuts the fill cost of flashes, fades and blasts.
+// With intscale the only reduced size is half, upscaled with nearest
+// filtering so pixels stay square, otherwise the scale follows the quality
+// level and is upscaled linearly.
+class Resolution {
+  public:
+
+    explicit Resolution(const Graphics::Config& config);
+    ~Resolution();
+
+    Resolution(const Resolution&) = delete;
+    Resolution& operator=(const Resolution&) = delete;
+
+    // sends the following draws to the target at the current scale
+    void begin();
+    // stretches the target over the screen and draws to the screen again
+    void end();
+
+    float scale() const { return scale_; }
+
+  private:
+
+    int width_, height_;
+    bool intscale_;
+
+    SDL_Renderer* renderer_;
+    SDL_Texture* target_;
+    bool unsupported_, active_;
+    float scale_;
+
+    bool create();
+};
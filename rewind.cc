@@ -0,0 +1,215 @@
+#include "rewind.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "trace.h"
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  // a keyframe a second at 60 Hz
+  constexpr size_t kKeyframe = 60;
+  // unchanged bytes a literal run swallows before it ends, a new run costs
+  // two lengths of its own
+  constexpr size_t kGap = 4;
+
+  struct Frame {
+    bool key;
+    // decoded size
+    size_t size;
+    std::vector<uint8_t> data;
+  };
+
+  std::deque<Frame> frames;
+  // encoded buffers of dropped frames, reused so recording doesn't allocate
+  std::vector<std::vector<uint8_t>> spare;
+  // latest frame decoded, the next frame is encoded against it
+  std::vector<uint8_t> latest, current, diff;
+  size_t budget = 0, bytes = 0, since_key = 0;
+  Histogram times;
+
+  void put(std::vector<uint8_t>& out, size_t n) {
+    for (; n >= 0x80; n >>= 7) out.push_back((uint8_t)(n | 0x80));
+    out.push_back((uint8_t)n);
+  }
+
+  size_t get(const uint8_t*& in) {
+    size_t n = 0;
+    for (int shift = 0;; shift += 7) {
+      const uint8_t b = *in++;
+      n |= (size_t)(b & 0x7f) << shift;
+      if (b < 0x80) return n;
+    }
+  }
+
+  // frame xor base as pairs of a run of unchanged bytes and a run of
+  // changed ones followed by the changed bytes, base counts as zero past
+  // its end
+  void encode(const std::vector<uint8_t>& frame, const std::vector<uint8_t>& base, std::vector<uint8_t>& out) {
+    const size_t n = frame.size();
+    const size_t common = std::min(n, base.size());
+    diff.resize(n);
+    for (size_t i = 0; i < common; ++i) diff[i] = frame[i] ^ base[i];
+    std::copy(frame.begin() + common, frame.end(), diff.begin() + common);
+
+    out.clear();
+    size_t i = 0;
+    while (i < n) {
+      const size_t start = i;
+      while (i < n && diff[i] == 0) ++i;
+      const size_t literal = i;
+
+      size_t zeros = 0;
+      while (i < n && zeros < kGap) {
+        zeros = diff[i] ? 0 : zeros + 1;
+        ++i;
+      }
+      i -= zeros;
+
+      put(out, literal - start);
+      put(out, i - literal);
+      out.insert(out.end(), diff.begin() + literal, diff.begin() + i);
+    }
+  }
+
+  // turns the frame before into this one in place
+  void decode(const Frame& frame, std::vector<uint8_t>& out) {
+    out.resize(frame.size, 0);
+    const uint8_t* in = frame.data.data();
+    const uint8_t* end = in + frame.data.size();
+    size_t at = 0;
+    while (in < end) {
+      at += get(in);
+      const size_t n = get(in);
+      for (size_t i = 0; i < n; ++i) out[at + i] ^= in[i];
+      in += n;
+      at += n;
+    }
+  }
+
+  // frames held, oldest first, decoded up to index
+  void rebuild(size_t index, std::vector<uint8_t>& out) {
+    size_t key = index;
+    while (!frames[key].key) --key;
+
+    out.clear();
+    for (size_t i = key; i <= index; ++i) decode(frames[i], out);
+  }
+
+  void drop_front() {
+    bytes -= frames.front().data.size();
+    spare.push_back(std::move(frames.front().data));
+    frames.pop_front();
+  }
+
+  void drop_back() {
+    bytes -= frames.back().data.size();
+    spare.push_back(std::move(frames.back().data));
+    frames.pop_back();
+  }
+}
+
+void Rewind::start(size_t b) {
+  budget = b;
+  clear();
+}
+
+void Rewind::stop() {
+  budget = 0;
+  clear();
+  spare.clear();
+  spare.shrink_to_fit();
+}
+
+bool Rewind::active() {
+  return budget > 0;
+}
+
+void Rewind::clear() {
+  frames.clear();
+  latest.clear();
+  bytes = 0;
+  since_key = 0;
+  times.clear();
+}
+
+void Rewind::record(const Simulation& sim) {
+  if (!active()) return;
+  TRACE_SCOPE("Rewind::record");
+  const auto start = Clock::now();
+
+  sim.save(current);
+
+  Frame frame = { since_key == 0 || frames.empty(), current.size(), {} };
+  if (!spare.empty()) {
+    frame.data.swap(spare.back());
+    spare.pop_back();
+  }
+  static const std::vector<uint8_t> none;
+  encode(current, frame.key ? none : latest, frame.data);
+
+  // entities dying early in a pool shift everything after them, a frame
+  // that barely packs as a delta starts a new run instead
+  if (!frame.key && frame.data.size() > current.size() / 2) {
+    frame.key = true;
+    encode(current, none, frame.data);
+  }
+
+  const bool key = frame.key;
+  bytes += frame.data.size();
+  frames.push_back(std::move(frame));
+  latest.swap(current);
+  since_key = key ? 1 : (since_key + 1) % kKeyframe;
+
+  // a whole second at a time from the front, the newest always stays
+  while (bytes > budget) {
+    size_t next = 1;
+    while (next < frames.size() && !frames[next].key) ++next;
+    if (next == frames.size()) break;
+    for (size_t i = 0; i < next; ++i) drop_front();
+  }
+
+  times.add(std::chrono::duration<float, std::milli>(Clock::now() - start).count());
+  Trace::counter("rewind frames", frames.size());
+  Trace::counter("rewind KiB", bytes / 1024);
+}
+
+bool Rewind::restore(size_t back, Simulation& sim) {
+  if (back >= frames.size()) return false;
+  TRACE_SCOPE("Rewind::restore");
+
+  if (back == 0) {
+    sim.load(latest);
+  } else {
+    rebuild(frames.size() - 1 - back, current);
+    sim.load(current);
+  }
+  return true;
+}
+
+void Rewind::truncate(size_t back) {
+  if (back == 0) return;
+  if (back >= frames.size()) {
+    clear();
+    return;
+  }
+
+  for (size_t i = 0; i < back; ++i) drop_back();
+  rebuild(frames.size() - 1, latest);
+
+  since_key = 0;
+  for (size_t i = frames.size(); i > 0 && !frames[i - 1].key; --i) ++since_key;
+  since_key = (since_key + 1) % kKeyframe;
+}
+
+Rewind::Stats Rewind::stats() {
+  return { frames.size(), bytes, latest.size(), frames.empty() ? 0 : frames.back().data.size() };
+}
+
+const Histogram& Rewind::record_times() {
+  return times;
+}
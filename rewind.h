@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+#include "histogram.h"
+#include "simulation.h"
+
+// Recent history of the game for rewind debugging and crash reproduction.
+// Every frame the whole simulation is saved and kept as its byte wise XOR
+// against the frame before, run length encoded, so the parts of the state
+// that didn't change cost a few bytes.  A full keyframe starts every second
+// of deltas, or sooner when a frame doesn't pack, so a restore never
+// replays more than that, and the oldest run is dropped whenever the
+// history is over its memory budget.
+namespace Rewind {
+  struct Stats {
+    size_t frames, bytes;
+    // the latest frame before and after encoding
+    size_t raw, encoded;
+  };
+
+  // a budget in bytes, 0 keeps it off
+  void start(size_t budget);
+  void stop();
+  bool active();
+
+  // forgets every frame, for a new game
+  void clear();
+
+  // call after every step
+  void record(const Simulation& sim);
+  // back counts frames from the latest, 0 is the one just recorded; false
+  // when that frame isn't held any more
+  bool restore(size_t back, Simulation& sim);
+  // drops the frames newer than back so recording carries on from there
+  void truncate(size_t back);
+
+  Stats stats();
+  // time spent in record, saving and encoding together
+  const Histogram& record_times();
+}
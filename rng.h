@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// PCG32 (pcg-random.org): 16 bytes of state and a handful of instructions
+// per draw.  Every stream id selects an independent sequence for the same
+// seed, so each system can own its own stream and stay reproducible no
+// matter how draws from the other systems interleave.
+class Rng {
+  public:
+
+    using result_type = uint32_t;
+
+    constexpr Rng(uint64_t seed = 0, uint64_t stream = 0) : state_(0), inc_((stream << 1u) | 1u) {
+      next();
+      state_ += seed;
+      next();
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+    constexpr result_type operator()() { return next(); }
+
+    constexpr uint32_t next() {
+      const uint64_t old = state_;
+      state_ = old * 6364136223846793005ull + inc_;
+      const uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+      const uint32_t rot = (uint32_t)(old >> 59u);
+      return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+    }
+
+    // uniform in [0, 1) from the top 24 bits
+    constexpr float unit() { return (next() >> 8) * (1.0f / 16777216.0f); }
+    constexpr float uniform(float lo, float hi) { return lo + (hi - lo) * unit(); }
+
+    // uniform in [lo, hi], bias is negligible for the small ranges used here
+    constexpr int range(int lo, int hi) {
+      return lo + (int)(((uint64_t)next() * (uint64_t)(hi - lo + 1)) >> 32);
+    }
+
+    void fill(float* out, size_t count, float lo, float hi) {
+      const float scale = (hi - lo) * (1.0f / 16777216.0f);
+      for (size_t i = 0; i < count; ++i) out[i] = lo + (next() >> 8) * scale;
+    }
+
+    // a new generator on its own stream, seeded from this one
+    Rng split(uint64_t stream) {
+      const uint64_t seed = ((uint64_t)next() << 32) | next();
+      return Rng(seed, stream);
+    }
+
+  private:
+
+    uint64_t state_, inc_;
+};
@@ -0,0 +1,150 @@
+#include "shapes.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "rng.h"
+#include "trace.h"
+
+namespace {
+  // fixed so every run, and every replay, sees the same asteroid meshes
+  constexpr uint64_t kAsteroidSeed = 0x6879647261;
+
+  // cells across the distance field, a 25 px drone gets ~1.5 px cells
+  constexpr size_t kField = 32;
+
+  enum : Shapes::Handle { kShip, kSaucer, kFirstAsteroid };
+
+  float segment_distance(pos p, pos a, pos b) {
+    const pos ab = b - a, ap = p - a;
+    const float len2 = ab.dist2({});
+    const float t = len2 > 0 ? std::clamp((ap.x * ab.x + ap.y * ab.y) / len2, 0.0f, 1.0f) : 0.0f;
+    return std::sqrt(p.dist2(a + ab * t));
+  }
+
+  // half open crossing test, unlike polygon::contains it stays right for
+  // grid points level with a vertex
+  bool inside(pos p, const std::vector<pos>& edges) {
+    bool in = false;
+    for (size_t i = 1; i < edges.size(); ++i) {
+      const pos a = edges[i - 1], b = edges[i];
+      if ((a.y > p.y) != (b.y > p.y) && p.x < a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y)) in = !in;
+    }
+    return in;
+  }
+
+  void make_field(Shapes::Shape& shape) {
+    const size_t n = kField + 1;
+    const auto& edges = shape.outline.points;
+    shape.cell = 2 * shape.radius / kField;
+    shape.field.resize(n * n);
+
+    for (size_t y = 0; y < n; ++y) {
+      for (size_t x = 0; x < n; ++x) {
+        const pos p = { -shape.radius + x * shape.cell, -shape.radius + y * shape.cell };
+        float d = std::numeric_limits<float>::max();
+        for (size_t i = 1; i < edges.size(); ++i) d = std::min(d, segment_distance(p, edges[i - 1], edges[i]));
+        shape.field[y * n + x] = inside(p, edges) ? -d : d;
+      }
+    }
+  }
+
+  Shapes::Shape make_shape(const polygon& outline) {
+    Shapes::Shape shape = { outline, {}, 0.0f, {}, 0.0f };
+    for (const auto& p : outline.points) {
+      shape.points.push_back({ p.mag(), p.angle() });
+      shape.radius = std::max(shape.radius, p.mag());
+    }
+    make_field(shape);
+    return shape;
+  }
+
+  polygon make_asteroid(Rng& rng) {
+    const size_t sides = rng.range(5, 11);
+    polygon poly;
+    for (size_t i = 0; i < sides; ++i) {
+      const pos w = { rng.uniform(-0.25f, 0.25f), rng.uniform(-0.25f, 0.25f) };
+      poly.points.emplace_back(pos::polar(1.0f, 2 * M_PI * (float)i / (float)sides) + w);
+    }
+    poly.points.emplace_back(poly.points[0]);
+    return poly;
+  }
+
+  const std::vector<Shapes::Shape>& library() {
+    static const std::vector<Shapes::Shape> shapes = [] {
+      TRACE_SCOPE("Shapes::library");
+      std::vector<Shapes::Shape> s;
+
+      s.push_back(make_shape({
+        pos::polar(1.0f, 0.0f),
+        pos::polar(1 / 3.0f, M_PI / 2),
+        pos::polar(1 / 3.0f, -M_PI / 2),
+      }));
+
+      s.push_back(make_shape({
+        pos::polar(1.0f, 0.0f),
+        pos::polar(1 / 3.0f, M_PI / 4),
+        pos::polar(1 / 3.0f, 3 * M_PI / 4),
+        pos::polar(1.0f, M_PI),
+        pos::polar(1 / 3.0f, 5 * M_PI / 4),
+        pos::polar(1 / 3.0f, 7 * M_PI / 4),
+      }));
+
+      Rng rng(kAsteroidSeed);
+      for (size_t i = 0; i < Shapes::kAsteroidVariants; ++i) s.push_back(make_shape(make_asteroid(rng)));
+
+      return s;
+    }();
+    return shapes;
+  }
+}
+
+polygon Shapes::Shape::place(const pos& at, float rotate, float scale) const {
+  polygon other;
+  other.points.reserve(points.size());
+  for (const auto& p : points) other.points.emplace_back(at + pos::polar(p.mag * scale, p.angle + rotate));
+  return other;
+}
+
+bool Shapes::Shape::contains(const pos& p) const {
+  const float fx = (p.x + radius) / cell;
+  const float fy = (p.y + radius) / cell;
+  if (!(fx >= 0 && fy >= 0 && fx < kField && fy < kField)) return false;
+
+  const size_t x = fx, y = fy;
+  const float tx = fx - x, ty = fy - y;
+  const float* row = &field[y * (kField + 1) + x];
+  const float* next = row + kField + 1;
+  const float d = (row[0] * (1 - tx) + row[1] * tx) * (1 - ty) + (next[0] * (1 - tx) + next[1] * tx) * ty;
+
+  // every corner is within a cell diagonal of p and the distance can't
+  // change faster than the distance moved, so neither can the blend
+  const float margin = cell * (float)M_SQRT2;
+  if (d > margin) return false;
+  if (d < -margin) return true;
+  return outline.contains(p);
+}
+
+Shapes::Handle Shapes::ship() {
+  return kShip;
+}
+
+Shapes::Handle Shapes::saucer() {
+  return kSaucer;
+}
+
+Shapes::Handle Shapes::asteroid(size_t variant) {
+  return kFirstAsteroid + variant % kAsteroidVariants;
+}
+
+const Shapes::Shape& Shapes::get(Handle handle) {
+  return library()[handle];
+}
+
+Shapes::Kind Shapes::kind(Handle handle) {
+  switch (handle) {
+    case kShip: return Kind::ship;
+    case kSaucer: return Kind::saucer;
+    default: return Kind::asteroid;
+  }
+}
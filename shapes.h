@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+
+// Immutable library of every outline in the game, built once on first use
+// and shared by all entities.  Shapes are unit sized; entities hold a handle
+// and a scale instead of their own copy of the points.  Asteroids pick one
+// of a fixed pool of jittered meshes, so crumbling one into three doesn't
+// build three new outlines.  Each shape also carries a coarse signed
+// distance field so a point test is a lookup rather than a walk around the
+// edges.
+namespace Shapes {
+  using Handle = uint16_t;
+
+  static constexpr size_t kAsteroidVariants = 32;
+
+  struct Shape {
+    struct Polar { float mag, angle; };
+
+    polygon outline;
+    // the outline in polar form, so placing it is a sin and cos per point
+    std::vector<Polar> points;
+    // furthest point from the origin, anything further away can't touch
+    float radius;
+    // distance to the outline, negative inside, sampled at the corners of
+    // a square grid of cells over [-radius, radius]
+    std::vector<float> field;
+    float cell;
+
+    polygon place(const pos& at, float rotate, float scale) const;
+
+    // p in the shape's own unit space; falls back to the outline only
+    // where the sampled field is too close to the edge to be sure
+    bool contains(const pos& p) const;
+  };
+
+  enum class Kind { ship, saucer, asteroid };
+
+  Handle ship();
+  Handle saucer();
+  Handle asteroid(size_t variant);
+
+  const Shape& get(Handle handle);
+  Kind kind(Handle handle);
+}
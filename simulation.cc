@@ -0,0 +1,1081 @@
+#include "simulation.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <type_traits>
+
+#include "entt/entity/snapshot.hpp"
+
+#include "components.h"
+#include "quality.h"
+#include "trace.h"
+#include "workers.h"
+
+using namespace entt::literals;
+
+namespace {
+  // entities created per frame, a few explosions' worth
+  constexpr size_t kSpawnBudget = 1500;
+  // frames an explosion may wait before it's not worth showing any more
+  constexpr size_t kSpawnMaxAge = 15;
+  // particles in a full quality explosion
+  constexpr size_t kParticles = 500;
+  // particles for all of a frame's explosions together, and the least any
+  // one of them gets before the rest are left without
+  constexpr size_t kExplosionBudget = 4 * kParticles;
+  constexpr size_t kMinBurst = 20;
+
+  // well past flocking, seeking and the largest asteroid, with a gap between
+  // the two so nothing flips tiers every frame on the boundary
+  constexpr float kDemoteMargin = 600.0f;
+  constexpr float kPromoteMargin = 400.0f;
+
+  // drones keep this far from their squad mates, and squads this far
+  // apart on top of their own size
+  constexpr float kSpacing = 50.0f;
+  // a squad's pull toward the player and away from other squads, as a
+  // share of each member's speed
+  constexpr float kSeek = 0.25f;
+  constexpr float kRepel = 0.5f;
+
+  pos unit(pos p) {
+    const float m = p.mag();
+    return m > 0 ? p / m : pos{};
+  }
+
+  // half the diagonal of the squad's bounds
+  float reach(const Squad& q) {
+    return std::sqrt(q.lo.dist2(q.hi)) / 2.0f;
+  }
+
+  // entt snapshot archives over a flat byte buffer, values are copied the
+  // way they sit in memory
+  class Writer {
+    public:
+
+      explicit Writer(std::vector<uint8_t>& out) : out_(out) {}
+
+      template <typename T> void operator()(const T& value) { write(value); }
+      template <typename T> void operator()(entt::entity e, const T& value) {
+        write(e);
+        write(value);
+      }
+
+    private:
+
+      std::vector<uint8_t>& out_;
+
+      template <typename T> void write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+        out_.insert(out_.end(), bytes, bytes + sizeof(T));
+      }
+
+      // padded components go field by field, so the bytes of a frame only
+      // depend on the game and unchanged state stays unchanged
+      void write(const Polygon& poly) { write(poly.shape); write(poly.scale); }
+      void write(const Bomb& bomb) { write(bomb.active); write(bomb.time); }
+      void write(const Timer& timer) { write(timer.lifetime); write(timer.expire); write(timer.start); }
+  };
+
+  class Reader {
+    public:
+
+      explicit Reader(const std::vector<uint8_t>& in) : in_(in), at_(0) {}
+
+      template <typename T> void operator()(T& value) { read(value); }
+      template <typename T> void operator()(entt::entity& e, T& value) {
+        read(e);
+        read(value);
+      }
+
+    private:
+
+      const std::vector<uint8_t>& in_;
+      size_t at_;
+
+      template <typename T> void read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        std::memcpy(&value, in_.data() + at_, sizeof(T));
+        at_ += sizeof(T);
+      }
+
+      void read(Polygon& poly) { read(poly.shape); read(poly.scale); }
+      void read(Bomb& bomb) { read(bomb.active); read(bomb.time); }
+      void read(Timer& timer) { read(timer.lifetime); read(timer.expire); read(timer.start); }
+  };
+
+  // every component a game can hold, a new one has to be added here or
+  // it's lost on restore
+  template <typename... T> struct Pools {
+    static void save(const entt::snapshot& snapshot, Writer& archive) {
+      snapshot.component<T...>(archive);
+    }
+
+    static void load(const entt::snapshot_loader& loader, Reader& archive) {
+      loader.component<T...>(archive);
+    }
+  };
+
+  using Saved = Pools<
+    Health, Position, Velocity, Angle, Bump, MaxVelocity, Acceleration,
+    Rotation, Spin, TargetDir, Color, PlayerControl, Collision, Crumble,
+    Bullet, Bomb, Blast, Firing, ScreenWrap, Polygon, Timer, FadeOut, Flash,
+    Particle, HasDrop, KilledByPlayer, KillOffScreen, BounceWalls,
+    ReturnToField, SeekPlayer, Flocking, Squad, Distant>;
+}
+
+Simulation::Simulation(const Settings& settings) :
+  settings_(settings),
+  pools_(reg_),
+  spawn_rng_(settings.seed, 1), weapon_rng_(settings.seed, 2), effect_rng_(settings.seed, 3),
+  spawn_queue_(kSpawnBudget, kSpawnMaxAge),
+  state_(State::playing),
+  score_(0), combo_(0), best_combo_(0),
+  bombs_(3), bomb_cooldown_(0.0f),
+  spawns_(3.0f), spawn_timer_(10.0f),
+  roid_timer_(60.0f),
+  survived_(0.0f),
+  tiers_({ 0, 0 }),
+  clock_(0.0f),
+  timers_(1 / 60.0f)
+{
+  TRACE_SCOPE("Simulation::Simulation");
+  events_.sink<Impact>().connect<&Simulation::on_impact>(*this);
+  events_.sink<Death>().connect<&Simulation::on_death>(*this);
+  events_.sink<Detonation>().connect<&Simulation::on_detonation>(*this);
+
+  const auto player = reg_.create();
+  reg_.emplace<Color>(player, 0xd8ff00ff);
+  reg_.emplace<Polygon>(player, Shapes::ship(), 15.0f);
+  reg_.emplace<Position>(player, pos{ settings_.width / 2.0f, settings_.height / 2.0f });
+
+  reg_.emplace<PlayerControl>(player);
+  reg_.emplace<ScreenWrap>(player);
+
+  reg_.emplace<Acceleration>(player);
+  reg_.emplace<Velocity>(player, 0.0f);
+  reg_.emplace<Angle>(player, 0.0f);
+  reg_.emplace<Rotation>(player);
+
+  reg_.emplace<Health>(player, 100);
+
+  spawn_asteroid(200.0f);
+  spawn_asteroid(200.0f);
+  spawn_asteroid(200.0f);
+}
+
+void Simulation::step(const Controls& controls, float t) {
+  TRACE_SCOPE("Simulation::step");
+  sounds_.clear();
+  simulate(controls, t);
+  pools_.update(t);
+}
+
+void Simulation::save(std::vector<uint8_t>& out) const {
+  TRACE_SCOPE("Simulation::save");
+  out.clear();
+  Writer archive(out);
+
+  archive(state_);
+  archive(score_);
+  archive(combo_);
+  archive(best_combo_);
+  archive(bombs_);
+  archive(bomb_cooldown_);
+  archive(spawns_);
+  archive(spawn_timer_);
+  archive(roid_timer_);
+  archive(survived_);
+  archive(tiers_);
+  archive(clock_);
+  archive(spawn_rng_);
+  archive(weapon_rng_);
+  archive(effect_rng_);
+
+  spawn_queue_.save(archive);
+  timers_.save(archive);
+
+  entt::snapshot snapshot(reg_);
+  snapshot.entities(archive);
+  Saved::save(snapshot, archive);
+}
+
+void Simulation::load(const std::vector<uint8_t>& in) {
+  TRACE_SCOPE("Simulation::load");
+  Reader archive(in);
+
+  archive(state_);
+  archive(score_);
+  archive(combo_);
+  archive(best_combo_);
+  archive(bombs_);
+  archive(bomb_cooldown_);
+  archive(spawns_);
+  archive(spawn_timer_);
+  archive(roid_timer_);
+  archive(survived_);
+  archive(tiers_);
+  archive(clock_);
+  archive(spawn_rng_);
+  archive(weapon_rng_);
+  archive(effect_rng_);
+
+  spawn_queue_.load(archive);
+  timers_.load(archive);
+
+  // pools keep their capacity, the loader brings back the entity list and
+  // free list as they were so new entities get the same identifiers
+  reg_.clear();
+  entt::snapshot_loader loader(reg_);
+  loader.entities(archive);
+  Saved::load(loader, archive);
+
+  // derived from the registry and rebuilt by the next step
+  sweep_ = Sweep();
+  sounds_.clear();
+}
+
+void Simulation::simulate(const Controls& controls, float t) {
+  expiring(t);
+
+  if (state_ == State::paused) {
+    if (controls.pause) state_ = State::playing;
+    return;
+  } else if (state_ == State::playing) {
+    if (controls.pause) {
+      state_ = State::paused;
+      return;
+    }
+
+    user_input(controls);
+    firing(t);
+    bombs(t);
+
+    if (reg_.view<PlayerControl>().size() == 0) {
+      // player must be dead
+      state_ = State::lost;
+      survived_ = clock_;
+      play("dead.wav"_hs);
+      return;
+    }
+
+    if (spawn_timer_ > 0) {
+      spawn_timer_ -= t;
+      if (spawn_timer_ < 0) {
+        if (spawns_ >= 10) play("alert.wav"_hs);
+        spawn_drones((int)spawns_, 5000.0f);
+        spawns_ -= (int)spawns_;
+      }
+    } else if (spawns_ >= 1.0f) {
+      spawn_timer_ = 1.0f;
+    }
+
+    roid_timer_ -= t;
+    if (roid_timer_ <= 0) {
+      spawn_asteroid(2000.0f);
+      roid_timer_ += 60;
+    }
+
+    if (bomb_cooldown_ > 0) bomb_cooldown_ -= t;
+  }
+
+  lod();
+
+  // movement systems
+  acceleration(t);
+  rotation(t);
+  spin(t);
+  steering(t);
+  flocking();
+  seek_player();
+  return_to_field();
+  bounce_walls();
+  max_velocity();
+  movement(t);
+
+  collision();
+
+  // cleanup
+  kill_dead();
+  kill_oob();
+  effects();
+  spawning();
+
+  Trace::counter("entities", reg_.alive());
+  Trace::counter("particles", reg_.view<Particle>().size());
+  Trace::counter("bullets", reg_.view<Bullet>().size());
+  Trace::counter("full sim", tiers_.full);
+  Trace::counter("distant sim", tiers_.distant);
+}
+
+void Simulation::play(entt::id_type sample) {
+  sounds_.push_back({ sample, false, {} });
+}
+
+void Simulation::play(entt::id_type sample, pos source) {
+  sounds_.push_back({ sample, true, source });
+}
+
+bool Simulation::oob(pos p) const {
+  if (p.x < 0 || p.x > settings_.width) return true;
+  if (p.y < 0 || p.y > settings_.height) return true;
+  return false;
+}
+
+// how far outside the field a point is, 0 when it's on it
+float Simulation::outside(pos p) const {
+  const float dx = std::max({ 0.0f, -p.x, p.x - settings_.width });
+  const float dy = std::max({ 0.0f, -p.y, p.y - settings_.height });
+  return std::max(dx, dy);
+}
+
+void Simulation::kill_dead() {
+  TRACE_SCOPE("Simulation::kill_dead");
+  auto view = reg_.view<const Health, const Position, const Color>();
+  for (const auto e : view) {
+    if (view.get<const Health>(e).health <= 0) {
+      const pos p = view.get<const Position>(e).p;
+      if (reg_.all_of<Crumble>(e)) {
+        const float s = reg_.get<const Crumble>(e).size;
+        spawn_queue_.push(Priority::gameplay, { Spawn::Kind::asteroid, p, s, 0, entt::null }, 3);
+      } else {
+        spawns_ += 1.5f;
+      }
+
+      events_.enqueue<Death>(p, view.get<const Color>(e).color);
+      if (reg_.all_of<KilledByPlayer>(e)) {
+        score_ += std::floor(100 * std::exp(combo_++ / 10.0f));
+        if (combo_ > best_combo_) best_combo_ = combo_;
+      }
+      reg_.destroy(e);
+    }
+  }
+}
+
+void Simulation::on_impact(const Impact& impact) {
+  if (impact.contact == Contact::player) {
+    effects_.hurt = true;
+    play("hurt.wav"_hs, impact.p);
+  } else {
+    play("hit.wav"_hs, impact.p);
+  }
+}
+
+void Simulation::on_death(const Death& death) {
+  effects_.deaths.push_back(death);
+  play("boom.wav"_hs, death.p);
+}
+
+void Simulation::on_detonation(const Detonation&) {
+  effects_.detonated = true;
+  play("nuke.wav"_hs);
+}
+
+// everything the frame reported, handled once: at most one screen flash,
+// and one particle budget split between the frame's explosions
+void Simulation::effects() {
+  TRACE_SCOPE("Simulation::effects");
+  events_.update();
+
+  if (effects_.detonated) {
+    flash(0xffffffff, 1.5f);
+  } else if (effects_.hurt) {
+    flash(0xd8ff0033, 0.2f);
+  }
+
+  const size_t deaths = effects_.deaths.size();
+  size_t budget = Quality::scale(kExplosionBudget);
+  for (const auto& d : effects_.deaths) {
+    if (budget == 0) break;
+    const size_t share = std::max(kMinBurst, budget / deaths);
+    const size_t count = std::min({ Quality::scale(kParticles), share, budget });
+    explosion(d.p, d.color, count);
+    budget -= count;
+  }
+
+  Trace::counter("deaths", deaths);
+  effects_.hurt = effects_.detonated = false;
+  effects_.deaths.clear();
+}
+
+void Simulation::spawning() {
+  TRACE_SCOPE("Simulation::spawning");
+  spawn_queue_.drain([this](const Spawn& spawn, size_t count) {
+    switch (spawn.kind) {
+      case Spawn::Kind::drone:
+        for (size_t i = 0; i < count; ++i) spawn_drone(spawn.p, spawn.color, spawn.squad);
+        break;
+      case Spawn::Kind::asteroid:
+        for (size_t i = 0; i < count; ++i) spawn_asteroid_at(spawn.p, spawn.size);
+        break;
+      case Spawn::Kind::particle:
+        burst(spawn.p, spawn.color, count);
+        break;
+    }
+  });
+
+  Trace::counter("spawn queue", spawn_queue_.pending());
+  Trace::counter("spawns dropped", spawn_queue_.dropped());
+}
+
+void Simulation::kill_oob() {
+  TRACE_SCOPE("Simulation::kill_oob");
+  auto view = reg_.view<const Position, const KillOffScreen>();
+  for (const auto e : view) {
+    if (oob(view.get<const Position>(e).p)) reg_.destroy(e);
+  }
+}
+
+void Simulation::user_input(const Controls& controls) {
+  TRACE_SCOPE("Simulation::user_input");
+  auto players = reg_.view<const PlayerControl, Acceleration, Rotation>();
+  for (auto p : players) {
+    float& accel = players.get<Acceleration>(p).accel;
+    float& rot = players.get<Rotation>(p).rot;
+
+    accel = 0.0f;
+    if (controls.thrust) accel += 1000.0f;
+    if (controls.reverse) accel -= 200.0f;
+
+    rot = 0.0f;
+    if (controls.left) rot -= 3.0f;
+    if (controls.right) rot += 3.0f;
+
+    if (controls.fire) {
+      static_cast<void>(reg_.get_or_emplace<Firing>(p));
+    } else {
+      reg_.remove<Firing>(p);
+    }
+
+    if (controls.bomb) {
+      if (bombs_ == 0 || bomb_cooldown_ > 0) {
+        play("nope.wav"_hs);
+      } else {
+        play("drop.wav"_hs);
+        bomb_cooldown_ = 90.0f;
+        --bombs_;
+
+        auto bomb = reg_.create();
+        reg_.emplace<Bomb>(bomb);
+        reg_.emplace<Position>(bomb, reg_.get<const Position>(p).p);
+        reg_.emplace<Angle>(bomb, reg_.get<const Angle>(p).angle);
+        reg_.emplace<Velocity>(bomb, reg_.get<const Velocity>(p).vel - 50);
+        reg_.emplace<Acceleration>(bomb);
+      }
+    }
+  }
+}
+
+void Simulation::collision() {
+  TRACE_SCOPE("Simulation::collision");
+
+  // world space shapes are built once per frame, the narrow phase only reads
+  // these lists and never touches the registry
+  const auto place = [](auto& view, entt::entity e, bool player) -> Body {
+    const pos p = view.template get<const Position>(e).p;
+    const Polygon& poly = view.template get<const Polygon>(e);
+    const Shapes::Shape& shape = Shapes::get(poly.shape);
+    const float angle = view.template get<const Angle>(e).angle;
+    return {
+      e, p, shape.radius * poly.scale,
+      shape.place(p, angle, poly.scale),
+      &shape, pos::polar(1.0f / poly.scale, angle),
+      Shapes::kind(poly.shape), player,
+    };
+  };
+
+  bodies_.clear();
+  auto objects = reg_.view<const PlayerControl, const Position, const Angle, const Polygon, Health>();
+  for (auto o : objects) bodies_.push_back(place(objects, o, true));
+
+  auto targets = reg_.view<const Collision, const Position, const Angle, const Polygon, Health>(entt::exclude<Distant>);
+  for (auto t : targets) bodies_.push_back(place(targets, t, false));
+
+  bounds_.clear();
+  for (const auto& b : bodies_) {
+    bounds_.push_back({ b.e, { b.p.x - b.radius, b.p.y - b.radius }, { b.p.x + b.radius, b.p.y + b.radius } });
+  }
+  sweep_.update(bounds_);
+  const auto& pairs = sweep_.pairs();
+
+  Trace::counter("sweep pairs", pairs.size());
+  Trace::counter("sweep moves", sweep_.moves());
+
+  auto bullets = reg_.view<const Bullet, const Position>();
+  shots_.clear();
+  for (auto b : bullets) shots_.push_back({ b, bullets.get<const Bullet>(b).source, bullets.get<const Position>(b).p });
+
+  // one item per candidate pair followed by one per bullet, each worker
+  // appends to its own hit list
+  const size_t items = pairs.size() + shots_.size();
+  hits_.resize(settings_.parallel ? Workers::count() : 1);
+  for (auto& h : hits_) h.clear();
+
+  const auto narrow_phase = [&](size_t begin, size_t end, size_t worker) {
+    TRACE_SCOPE("Simulation::narrow_phase");
+    auto& hits = hits_[worker];
+    for (size_t i = begin; i < end; ++i) {
+      if (i < pairs.size()) {
+        const Body* a = &bodies_[pairs[i].a];
+        const Body* b = &bodies_[pairs[i].b];
+        if (a->player && b->player) continue;
+        if (b->player) std::swap(a, b);
+
+        const float reach = a->radius + b->radius;
+        if (a->p.dist2(b->p) > reach * reach) continue;
+
+        if (a->player) {
+          if (b->shape.intersect(a->shape)) hits.push_back({ i, Contact::player, a->e, b->e });
+        } else if (a->kind == b->kind) {
+          // a flock or a crumbled asteroid sits this close all the time,
+          // it only needs spreading out so the outlines can stay approximate
+          hits.push_back({ i, Contact::push, a->e, b->e });
+        } else if (a->shape.intersect(b->shape)) {
+          hits.push_back({ i, Contact::crash, a->e, b->e });
+        }
+      } else {
+        const Shot& s = shots_[i - pairs.size()];
+        sweep_.query(s.p, [&](size_t index) {
+          const Body& t = bodies_[index];
+          if (t.player || t.e == s.source || t.p.dist2(s.p) > t.radius * t.radius) return false;
+          const pos d = s.p - t.p;
+          if (!t.model->contains({ d.x * t.axis.x + d.y * t.axis.y, d.y * t.axis.x - d.x * t.axis.y })) return false;
+          hits.push_back({ i, Contact::shot, s.e, t.e });
+          return true;
+        });
+      }
+    }
+  };
+
+  if (settings_.parallel) {
+    Workers::parallel_for(items, 32, narrow_phase);
+  } else {
+    narrow_phase(0, items, 0);
+  }
+
+  // back in the order a serial pass would have found them, so the outcome
+  // doesn't depend on the number of threads
+  merged_.clear();
+  for (const auto& h : hits_) merged_.insert(merged_.end(), h.begin(), h.end());
+  std::sort(merged_.begin(), merged_.end(), [](const Hit& a, const Hit& b) { return a.order < b.order; });
+
+  const auto knock = [this](entt::entity a, entt::entity b, float vel) {
+    const pos ap = reg_.get<const Position>(a).p;
+    const pos bp = reg_.get<const Position>(b).p;
+    reg_.emplace_or_replace<Bump>(a, (ap - bp).angle(), vel);
+    reg_.emplace_or_replace<Bump>(b, (bp - ap).angle(), vel);
+    return ap;
+  };
+
+  for (const auto& hit : merged_) {
+    switch (hit.contact) {
+      case Contact::player: {
+        const auto o = hit.a, t = hit.b;
+        reg_.get<Health>(o).health--;
+        reg_.get<Health>(t).health--;
+        combo_ = 0;
+
+        events_.enqueue<Impact>(Contact::player, knock(o, t, Bump{}.vel));
+        break;
+      }
+
+      case Contact::crash: {
+        reg_.get<Health>(hit.a).health--;
+        reg_.get<Health>(hit.b).health--;
+        events_.enqueue<Impact>(Contact::crash, knock(hit.a, hit.b, Bump{}.vel));
+        break;
+      }
+
+      case Contact::push: {
+        // never cut short a harder knock that's still playing out
+        if (!reg_.all_of<Bump>(hit.a) && !reg_.all_of<Bump>(hit.b)) knock(hit.a, hit.b, 0.5f);
+        break;
+      }
+
+      case Contact::shot: {
+        const auto b = hit.a, t = hit.b;
+        const auto s = reg_.get<const Bullet>(b).source;
+        int& health = reg_.get<Health>(t).health;
+        if (--health == 0 && reg_.all_of<PlayerControl>(s)) {
+          reg_.emplace_or_replace<KilledByPlayer>(t);
+        }
+        events_.enqueue<Impact>(Contact::shot, reg_.get<const Position>(b).p);
+        reg_.destroy(b);
+        break;
+      }
+    }
+  }
+}
+
+void Simulation::acceleration(float t) {
+  TRACE_SCOPE("Simulation::acceleration");
+  auto view = reg_.view<Velocity, const Acceleration>();
+  for (const auto e : view) {
+    float& vel = view.get<Velocity>(e).vel;
+    const float friction = 0.01 * vel * vel * (vel < 0 ? -1 : 1);
+    vel += (view.get<const Acceleration>(e).accel - friction) * t;
+  }
+}
+
+void Simulation::rotation(float t) {
+  TRACE_SCOPE("Simulation::rotation");
+  auto view = reg_.view<Angle, const Rotation>();
+  for (const auto e : view) {
+    float &angle = view.get<Angle>(e).angle;
+    angle += view.get<const Rotation>(e).rot * t;
+  }
+}
+
+void Simulation::spin(float t) {
+  TRACE_SCOPE("Simulation::spin");
+  auto view = reg_.view<Spin>();
+  for (const auto e : view) {
+    auto& s = view.get<Spin>(e);
+    s.dir += s.spin * t;
+  }
+}
+
+void Simulation::steering(float t) {
+  TRACE_SCOPE("Simulation::steering");
+  auto view = reg_.view<Angle, const TargetDir>(entt::exclude<Distant>);
+  for (const auto e : view) {
+    float &a = view.get<Angle>(e).angle;
+    a += std::clamp(view.get<const TargetDir>(e).target - a, -t, t);
+  }
+}
+
+void Simulation::flocking() {
+  TRACE_SCOPE("Simulation::flocking");
+
+  auto squads = reg_.view<Squad>();
+  for (const auto s : squads) {
+    Squad& q = squads.get<Squad>(s);
+    q.alive = q.active = 0;
+    q.center = q.heading = q.steer = {};
+  }
+
+  // distant drones fly straight in and only count as alive
+  auto members = reg_.view<const Flocking>();
+  for (const auto e : members) ++reg_.get<Squad>(members.get<const Flocking>(e).squad).alive;
+
+  boids_.clear();
+  auto view = reg_.view<const Flocking, const Position, const Velocity, const Angle>(entt::exclude<Distant>);
+  for (const auto e : view) {
+    const auto s = view.get<const Flocking>(e).squad;
+    const pos p = view.get<const Position>(e).p;
+    Squad& q = reg_.get<Squad>(s);
+
+    if (q.active++ == 0) {
+      q.lo = q.hi = p;
+    } else {
+      q.lo = { std::min(q.lo.x, p.x), std::min(q.lo.y, p.y) };
+      q.hi = { std::max(q.hi.x, p.x), std::max(q.hi.y, p.y) };
+    }
+    q.center += p;
+    q.heading += pos::polar(view.get<const Velocity>(e).vel, view.get<const Angle>(e).angle);
+    boids_.push_back({ e, s, p, {} });
+  }
+
+  auto players = reg_.view<const PlayerControl, const Position>();
+  const bool seek = players.begin() != players.end();
+  const pos player = seek ? players.get<const Position>(*players.begin()).p : pos{};
+
+  // once per squad: where it is, where it's going and where it wants to go
+  flocks_.clear();
+  for (const auto s : squads) {
+    Squad& q = squads.get<Squad>(s);
+    if (q.alive == 0 && q.spawned == q.size) {
+      reg_.destroy(s);
+      continue;
+    }
+    if (q.active == 0) continue;
+
+    q.center /= q.active;
+    q.heading /= q.active;
+    if (seek) q.steer = unit(player - q.center) * kSeek;
+    flocks_.push_back(s);
+  }
+
+  // squads keep clear of each other as a whole
+  for (size_t i = 0; i < flocks_.size(); ++i) {
+    Squad& a = reg_.get<Squad>(flocks_[i]);
+    for (size_t j = i + 1; j < flocks_.size(); ++j) {
+      Squad& b = reg_.get<Squad>(flocks_[j]);
+      const float r = reach(a) + reach(b) + kSpacing;
+      if (a.center.dist2(b.center) > r * r) continue;
+
+      const pos away = unit(a.center - b.center) * kRepel;
+      a.steer += away;
+      b.steer -= away;
+    }
+  }
+
+  // separation only looks at squad mates: sorted by squad and then x, each
+  // boid checks ahead until the gap on x is past the spacing
+  std::sort(boids_.begin(), boids_.end(), [](const Boid& a, const Boid& b) {
+    if (a.squad != b.squad) return entt::to_integral(a.squad) < entt::to_integral(b.squad);
+    return a.p.x < b.p.x;
+  });
+  for (size_t i = 0; i < boids_.size(); ++i) {
+    Boid& a = boids_[i];
+    for (size_t j = i + 1; j < boids_.size() && boids_[j].squad == a.squad && boids_[j].p.x - a.p.x < kSpacing; ++j) {
+      Boid& b = boids_[j];
+      if (a.p.dist2(b.p) > kSpacing * kSpacing) continue;
+      a.avoid += a.p - b.p;
+      b.avoid += b.p - a.p;
+    }
+  }
+
+  for (const auto& b : boids_) {
+    const Squad& q = reg_.get<const Squad>(b.squad);
+    float& target = reg_.get<TargetDir>(b.e).target;
+
+    // a lone drone has nobody to flock with and goes for the player
+    if (q.active == 1) {
+      if (seek) target = (player - b.p).angle();
+      continue;
+    }
+
+    const float vel = reg_.get<const Velocity>(b.e).vel;
+    const pos v = pos::polar(vel, reg_.get<const Angle>(b.e).angle) +
+      (q.center - b.p) * 0.005f + b.avoid * 0.25f + q.heading * 0.05f + q.steer * vel;
+
+    // only set the target direction otherwise the ships will awkwardly speed up and slow down
+    target = v.angle();
+  }
+}
+
+void Simulation::seek_player() {
+  TRACE_SCOPE("Simulation::seek_player");
+  auto view = reg_.view<const SeekPlayer, const Position, TargetDir>(entt::exclude<Distant>);
+  auto players = reg_.view<const PlayerControl, const Position>();
+  for (const auto e : view) {
+    const float r = view.get<const SeekPlayer>(e).range;
+    const pos p = view.get<const Position>(e).p;
+    float& t = view.get<TargetDir>(e).target;
+
+    for (const auto pl : players) {
+      const pos pp = players.get<const Position>(pl).p;
+      if (pp.dist2(p) < r * r) {
+        t = (pp - p).angle();
+        break;
+      }
+    }
+  }
+}
+
+void Simulation::lod() {
+  TRACE_SCOPE("Simulation::lod");
+  const pos center = { settings_.width / 2.0f, settings_.height / 2.0f };
+  auto view = reg_.view<const Collision, const Polygon, const Position, Angle>(entt::exclude<PlayerControl>);
+
+  tiers_ = { 0, 0 };
+  for (const auto e : view) {
+    const pos p = view.get<const Position>(e).p;
+    const float d = outside(p);
+
+    if (reg_.all_of<Distant>(e)) {
+      if (d < kPromoteMargin) reg_.remove<Distant>(e);
+    } else if (d > kDemoteMargin) {
+      reg_.emplace<Distant>(e);
+      // head straight for the field, which is where return_to_field steers
+      if (reg_.all_of<ReturnToField>(e)) view.get<Angle>(e).angle = (center - p).angle();
+    }
+
+    if (reg_.all_of<Distant>(e)) {
+      ++tiers_.distant;
+    } else {
+      ++tiers_.full;
+    }
+  }
+}
+
+void Simulation::return_to_field() {
+  TRACE_SCOPE("Simulation::return_to_field");
+  const pos center = { settings_.width / 2.0f, settings_.height / 2.0f };
+  auto view = reg_.view<const ReturnToField, const Position, TargetDir>(entt::exclude<Distant>);
+  for (const auto e : view) {
+    const pos p = view.get<const Position>(e).p;
+    if (oob(p)) {
+      view.get<TargetDir>(e).target = (center - p).angle();
+    }
+  }
+}
+
+void Simulation::bounce_walls() {
+  TRACE_SCOPE("Simulation::bounce_walls");
+  auto view = reg_.view<const BounceWalls, const Position, Velocity, Angle>();
+  for (const auto e : view) {
+    const pos p = view.get<const Position>(e).p;
+    float& vel = view.get<Velocity>(e).vel;
+    float& angle = view.get<Angle>(e).angle;
+
+    pos v = pos::polar(vel, angle);
+
+    if (p.x < 0) v.x = std::abs(v.x);
+    if (p.x > settings_.width) v.x = -std::abs(v.x);
+    if (p.y < 0) v.y = std::abs(v.y);
+    if (p.y > settings_.height) v.y = -std::abs(v.y);
+
+    vel = v.mag();
+    angle = v.angle();
+  }
+}
+
+void Simulation::max_velocity() {
+  TRACE_SCOPE("Simulation::max_velocity");
+  auto view = reg_.view<Velocity, const MaxVelocity>();
+  for (const auto e : view) {
+    float& vel = view.get<Velocity>(e).vel;
+    const float max = view.get<const MaxVelocity>(e).max;
+    if (vel > max) vel = max;
+  }
+}
+
+void Simulation::movement(float t) {
+  TRACE_SCOPE("Simulation::movement");
+  auto view = reg_.view<Position, const Velocity, const Angle>();
+  for (const auto e : view) {
+    pos& p = view.get<Position>(e).p;
+    const float vel = view.get<const Velocity>(e).vel;
+    const float angle = view.get<const Angle>(e).angle;
+    p += pos::polar(vel, angle) * t;
+
+    if (reg_.all_of<ScreenWrap>(e)) {
+      while (p.x < 0) p.x += settings_.width;
+      while (p.x > settings_.width) p.x -= settings_.width;
+      while (p.y < 0) p.y += settings_.height;
+      while (p.y > settings_.height) p.y -= settings_.height;
+    }
+
+    if (reg_.all_of<Bump>(e)) {
+      auto& b = reg_.get<Bump>(e);
+      p += pos::polar(b.vel, b.dir);
+      b.vel -= 1.0f * t;
+      if (b.vel <= 0) reg_.remove<Bump>(e);
+    }
+  }
+}
+
+void Simulation::expiring(float t) {
+  TRACE_SCOPE("Simulation::expiring");
+  clock_ += t;
+  timers_.advance(clock_, [this](entt::entity e) {
+    // skip entities that were destroyed some other way since
+    if (!reg_.valid(e)) return;
+    const Timer* tm = reg_.try_get<Timer>(e);
+    if (tm && tm->expire) reg_.destroy(e);
+  });
+  Trace::counter("timers", timers_.size());
+}
+
+void Simulation::add_timer(entt::entity e, float lifetime) {
+  reg_.emplace<Timer>(e, lifetime, true, clock_);
+  timers_.schedule(e, clock_ + lifetime);
+}
+
+void Simulation::firing(float t) {
+  TRACE_SCOPE("Simulation::firing");
+  auto sources = reg_.view<Firing, const Position, const Angle, const Velocity>();
+  for (const auto s : sources) {
+    Firing& gun = sources.get<Firing>(s);
+
+    gun.time += t;
+    if (gun.time > gun.rate) {
+      gun.time -= gun.rate;
+      const pos p = sources.get<const Position>(s).p;
+      if (oob(p)) continue;
+
+      const float a = sources.get<const Angle>(s).angle;
+
+      const auto bullet = reg_.create();
+      reg_.emplace<Bullet>(bullet, s);
+      reg_.emplace<Collision>(bullet);
+      reg_.emplace<Position>(bullet, p + pos::polar(5, a));
+      reg_.emplace<Angle>(bullet, a + weapon_rng_.uniform(-gun.spread, gun.spread));
+      reg_.emplace<Velocity>(bullet, sources.get<const Velocity>(s).vel + 350.0f);
+      reg_.emplace<MaxVelocity>(bullet);
+      reg_.emplace<KillOffScreen>(bullet);
+
+      play("shot.wav"_hs, p);
+    }
+  }
+}
+
+void Simulation::bombs(float t) {
+  TRACE_SCOPE("Simulation::bombs");
+  auto bombs = reg_.view<Bomb>();
+  for (auto b : bombs) {
+    float& time = bombs.get<Bomb>(b).time;
+    const int ta = int(time);
+    time -= t;
+    const int tb = int(time);
+    if (tb != ta) play("beep.wav"_hs, reg_.get<const Position>(b).p);
+
+    if (time < 0) {
+      const pos p = reg_.get<const Position>(b).p;
+      auto blast = reg_.create();
+      reg_.emplace<Blast>(blast);
+      reg_.emplace<Position>(blast, p);
+      events_.enqueue<Detonation>(p);
+
+      reg_.destroy(b);
+    }
+  }
+
+  auto blasts = reg_.view<Blast, const Position>();
+  for (auto b : blasts) {
+    auto& blast = blasts.get<Blast>(b);
+    const auto p = blasts.get<const Position>(b).p;
+
+    auto view = reg_.view<Health, const Position>();
+    for (auto e : view) {
+      if (view.get<const Position>(e).p.dist2(p) < blast.rad * blast.rad) {
+        view.get<Health>(e).health--;
+        // TODO maybe do this only once per entity for a set amount
+        // as it stands this will annhiliate anything in the radius
+      }
+    }
+
+    if (blast.rad < 200.0f) {
+      blast.rad += t * 400.0f;
+    } else if (blast.fade > 0) {
+      blast.rad = 200.0f;
+      blast.fade -= t;
+    } else {
+      reg_.destroy(b);
+    }
+  }
+}
+
+void Simulation::spawn_drones(size_t count, float distance) {
+  TRACE_SCOPE("Simulation::spawn_drones");
+
+  const pos center = {settings_.width / 2.0f, settings_.height / 2.0f};
+  const pos p = center + pos::polar(distance, spawn_rng_.uniform(0, 2 * M_PI));
+  const uint32_t c = hsl{spawn_rng_.uniform(175, 325), 1.0f, 0.5f};
+
+  if (count >= 10) spawn_saucer(distance);
+
+  const auto squad = reg_.create();
+  reg_.emplace<Squad>(squad, (uint32_t)count);
+  spawn_queue_.push(Priority::gameplay, { Spawn::Kind::drone, p, 0, c, squad }, count);
+}
+
+void Simulation::spawn_drone(pos p, uint32_t color, entt::entity squad) {
+  const pos center = {settings_.width / 2.0f, settings_.height / 2.0f};
+
+  ++reg_.get<Squad>(squad).spawned;
+
+  const auto drone = reg_.create();
+  reg_.emplace<Health>(drone, 1);
+  reg_.emplace<Color>(drone, color);
+  reg_.emplace<Polygon>(drone, Shapes::ship(), 25.0f);
+  reg_.emplace<Position>(drone, p);
+  reg_.emplace<Collision>(drone);
+  reg_.emplace<Velocity>(drone, 200.0f);
+  const float angle = (center - p).angle() + spawn_rng_.uniform(-0.1f, 0.1f);
+  reg_.emplace<Angle>(drone, angle);
+  reg_.emplace<TargetDir>(drone, angle);
+  reg_.emplace<MaxVelocity>(drone, 500.0f);
+  reg_.emplace<SeekPlayer>(drone);
+  reg_.emplace<ReturnToField>(drone);
+  reg_.emplace<Flocking>(drone, squad);
+
+  if (spawn_rng_.unit() < 0.05f) reg_.emplace<Firing>(drone, 2.5f, (float)(M_PI / 4.0f));
+}
+
+void Simulation::spawn_saucer(float distance) {
+  TRACE_SCOPE("Simulation::spawn_saucer");
+  const pos center = {settings_.width / 2.0f, settings_.height / 2.0f};
+  const pos p = center + pos::polar(distance, spawn_rng_.uniform(0, 2 * M_PI));
+  const pos t = { spawn_rng_.uniform(0, settings_.width), spawn_rng_.uniform(0, settings_.height) };
+
+  const auto saucer = reg_.create();
+  reg_.emplace<Health>(saucer, 5);
+  reg_.emplace<Color>(saucer, (uint32_t)0xffd800ff);
+  reg_.emplace<Polygon>(saucer, Shapes::saucer(), 35.0f);
+  reg_.emplace<Position>(saucer, p);
+  reg_.emplace<Collision>(saucer);
+  reg_.emplace<Velocity>(saucer, 150.0f);
+  reg_.emplace<Angle>(saucer, (t - p).angle());
+  reg_.emplace<Firing>(saucer, 0.05f, (float)M_PI);
+}
+
+void Simulation::spawn_asteroid(float distance) {
+  TRACE_SCOPE("Simulation::spawn_asteroid");
+  const pos center = {settings_.width / 2.0f, settings_.height / 2.0f};
+  const pos p = center + pos::polar(distance, spawn_rng_.uniform(0, 2 * M_PI));
+  const pos t = {spawn_rng_.uniform(0, settings_.width), spawn_rng_.uniform(0, settings_.height)};
+
+  const auto roid = spawn_asteroid_at(p, 80.0f);
+  reg_.get<Angle>(roid).angle = (t - p).angle();
+  reg_.remove<ScreenWrap>(roid);
+}
+
+entt::entity Simulation::spawn_asteroid_at(pos p, float size) {
+  TRACE_SCOPE("Simulation::spawn_asteroid_at");
+  Rng& rng = spawn_rng_;
+  const float wiggle = size / 4.0f;
+  const auto shape = Shapes::asteroid(rng.range(0, Shapes::kAsteroidVariants - 1));
+
+  const pos offset = { rng.uniform(-wiggle, wiggle) * 4.0f, rng.uniform(-wiggle, wiggle) * 4.0f };
+
+  const auto roid = reg_.create();
+  reg_.emplace<Color>(roid, hsl{45, rng.uniform(0.0f, 0.8f), 0.7f});
+  reg_.emplace<Polygon>(roid, shape, size);
+  reg_.emplace<Position>(roid, p + offset);
+  reg_.emplace<ScreenWrap>(roid);
+  reg_.emplace<Collision>(roid);
+  reg_.emplace<Velocity>(roid, rng.uniform(800.0f, 4000.0f) / size);
+  reg_.emplace<Angle>(roid, rng.uniform(0, 2 * M_PI));
+  reg_.emplace<Spin>(roid, rng.uniform(-0.75f, 0.75f));
+  reg_.emplace<Health>(roid, (int)size / 10);
+  if (size > 10.0f) reg_.emplace<Crumble>(roid, size / 2.0f);
+
+  return roid;
+}
+
+void Simulation::flash(uint32_t color, float lifetime) {
+  if (!settings_.effects) return;
+
+  // a flash of the same color that's still bright covers this one
+  const auto flashes = reg_.view<const Flash, const Timer, const Color>();
+  for (const auto f : flashes) {
+    if (flashes.get<const Color>(f).color == color && flashes.get<const Timer>(f).ratio(clock_) < 0.5f) return;
+  }
+
+  const auto flash = reg_.create();
+  reg_.emplace<Flash>(flash);
+  add_timer(flash, lifetime);
+  reg_.emplace<Color>(flash, color);
+}
+
+void Simulation::explosion(const pos& p, uint32_t color, size_t count) {
+  if (!settings_.effects) return;
+  spawn_queue_.push(Priority::cosmetic, { Spawn::Kind::particle, p, 0, color, entt::null }, count);
+}
+
+void Simulation::burst(const pos& p, uint32_t color, size_t count) {
+  TRACE_SCOPE("Simulation::burst");
+  count = std::min(count, kParticles);
+
+  // draw the whole burst up front, a tight loop the compiler can keep in registers
+  std::array<float, kParticles> angle, vel, lifetime;
+  effect_rng_.fill(angle.data(), count, 0, 2 * M_PI);
+  effect_rng_.fill(vel.data(), count, 100.0f, 500.0f);
+  effect_rng_.fill(lifetime.data(), count, Quality::lifetime(1.5f), Quality::lifetime(4.5f));
+
+  for (size_t i = 0; i < count; ++i) {
+    const auto pt = reg_.create();
+    reg_.emplace<Particle>(pt);
+    add_timer(pt, lifetime[i]);
+    reg_.emplace<Position>(pt, p);
+    reg_.emplace<Color>(pt, color);
+    reg_.emplace<Velocity>(pt, vel[i]);
+    reg_.emplace<Angle>(pt, angle[i]);
+    reg_.emplace<BounceWalls>(pt);
+  }
+}
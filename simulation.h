@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "entt/core/hashed_string.hpp"
+#include "entt/entity/registry.hpp"
+#include "entt/signal/dispatcher.hpp"
+
+#include "geometry.h"
+#include "pool_budget.h"
+#include "rng.h"
+#include "shapes.h"
+#include "spawn_queue.h"
+#include "sweep.h"
+#include "timer_wheel.h"
+
+// One game of Hydra without a window.  Owns the registry and every system
+// that moves it forward, and takes the field size and seed it plays with
+// instead of reading kConfig, so any number of these can run side by side.
+// GameScreen wraps one with input, sound and drawing; batch runs step them
+// headless on their own threads.  Sounds are only collected for the caller
+// to play.
+class Simulation {
+  public:
+
+    struct Settings {
+      float width, height;
+      uint64_t seed;
+      // particles and screen flashes, nothing else depends on them
+      bool effects = true;
+      // splits the narrow phase over the process wide worker pool, leave it
+      // off when many simulations already fill the cores
+      bool parallel = true;
+    };
+
+    // held buttons and this frame's presses
+    struct Controls {
+      bool thrust = false, reverse = false, left = false, right = false;
+      bool fire = false, bomb = false, pause = false;
+    };
+
+    struct Sound {
+      entt::id_type sample;
+      bool positional;
+      pos source;
+    };
+
+    enum class State { playing, paused, lost };
+
+    // how many collidable entities ran the full simulation last frame and
+    // how many were on the cheap distant path
+    struct Tiers { size_t full, distant; };
+
+    explicit Simulation(const Settings& settings);
+    // the event handlers are bound to this instance
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    void step(const Controls& controls, float t);
+
+    // the whole game between steps as flat bytes, for rewinding; load takes
+    // back anything save wrote for a simulation of the same size
+    void save(std::vector<uint8_t>& out) const;
+    void load(const std::vector<uint8_t>& in);
+
+    const Settings& settings() const { return settings_; }
+    const entt::registry& registry() const { return reg_; }
+    const PoolBudget& pools() const { return pools_; }
+    Tiers tiers() const { return tiers_; }
+
+    // sounds asked for during the last step
+    const std::vector<Sound>& sounds() const { return sounds_; }
+
+    State state() const { return state_; }
+    float clock() const { return clock_; }
+    // game clock when the player died
+    float survived() const { return survived_; }
+    int score() const { return score_; }
+    int combo() const { return combo_; }
+    int best_combo() const { return best_combo_; }
+    int bombs_left() const { return bombs_; }
+    float bomb_cooldown() const { return bomb_cooldown_; }
+
+  private:
+
+    // collision scratch, kept between frames so the lists don't reallocate
+    // axis is the body's rotation divided by its scale, it takes a world
+    // offset from p into the unit space of model
+    struct Body {
+      entt::entity e; pos p; float radius; polygon shape;
+      const Shapes::Shape* model; pos axis;
+      Shapes::Kind kind; bool player;
+    };
+    struct Shot { entt::entity e, source; pos p; };
+    // a player touching anything, two different kinds of things crashing,
+    // two of a kind overlapping, or a bullet landing
+    enum class Contact { player, crash, push, shot };
+    struct Hit { size_t order; Contact contact; entt::entity a, b; };
+
+    // what the frame's systems report for the effects pass: a contact that
+    // hurt something, something destroyed, and a bomb going off
+    struct Impact { Contact contact; pos p; };
+    struct Death { pos p; uint32_t color; };
+    struct Detonation { pos p; };
+
+    // the effects asked for so far this frame, applied together
+    struct Effects {
+      bool hurt = false, detonated = false;
+      std::vector<Death> deaths;
+    };
+
+    // one queued batch of identical entities
+    struct Spawn {
+      enum class Kind { drone, asteroid, particle } kind;
+      pos p;
+      float size;
+      uint32_t color;
+      entt::entity squad;
+    };
+
+    // flocking scratch, a drone on the field and its push away from its
+    // squad mates
+    struct Boid { entt::entity e, squad; pos p, avoid; };
+    using Priority = SpawnQueue<Spawn>::Priority;
+
+    Settings settings_;
+    entt::registry reg_;
+    PoolBudget pools_;
+    // one stream per system so a seed replays the same game no matter how
+    // much any one of them draws
+    Rng spawn_rng_, weapon_rng_, effect_rng_;
+    SpawnQueue<Spawn> spawn_queue_;
+    entt::dispatcher events_;
+    Effects effects_;
+    std::vector<Sound> sounds_;
+
+    State state_;
+    int score_, combo_, best_combo_;
+    int bombs_;
+    float bomb_cooldown_;
+    float spawns_, spawn_timer_;
+    float roid_timer_;
+    float survived_;
+    Tiers tiers_;
+
+    float clock_;
+    TimerWheel timers_;
+
+    Sweep sweep_;
+    std::vector<Body> bodies_;
+    std::vector<Sweep::Bounds> bounds_;
+    std::vector<Shot> shots_;
+    std::vector<std::vector<Hit>> hits_;
+    std::vector<Hit> merged_;
+
+    std::vector<Boid> boids_;
+    std::vector<entt::entity> flocks_;
+
+    void play(entt::id_type sample);
+    void play(entt::id_type sample, pos source);
+
+    bool oob(pos p) const;
+    float outside(pos p) const;
+
+    void simulate(const Controls& controls, float t);
+    void user_input(const Controls& controls);
+
+    void lod();
+
+    void collision();
+
+    void acceleration(float t);
+    void rotation(float t);
+    void spin(float t);
+    void steering(float t);
+    void flocking();
+    void seek_player();
+    void return_to_field();
+    void bounce_walls();
+    void max_velocity();
+    void movement(float t);
+
+    void expiring(float t);
+    void firing(float t);
+    void bombs(float t);
+
+    void kill_dead();
+    void kill_oob();
+    void effects();
+    void spawning();
+
+    void on_impact(const Impact& impact);
+    void on_death(const Death& death);
+    void on_detonation(const Detonation& detonation);
+
+    void spawn_drones(size_t count, float distance);
+    void spawn_drone(pos p, uint32_t color, entt::entity squad);
+    void spawn_saucer(float distance);
+    void spawn_asteroid(float distance);
+    entt::entity spawn_asteroid_at(pos p, float size);
+    void add_timer(entt::entity e, float lifetime);
+    void flash(uint32_t color, float lifetime);
+    void explosion(const pos& p, uint32_t color, size_t count);
+    void burst(const pos& p, uint32_t color, size_t count);
+};
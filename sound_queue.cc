@@ -0,0 +1,128 @@
+#include "sound_queue.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "trace.h"
+
+using namespace entt::literals;
+
+namespace {
+  struct Group {
+    Assets::Id id;
+    const char* stem;
+    size_t variants;  // numbered files to pick from at random, 0 for one file
+    size_t voices;
+    float length;     // seconds a voice is assumed to hold its channel
+    float priority;
+  };
+
+  constexpr Group kGroups[] = {
+    { "shot.wav"_hs,    "shot",    3, 2, 0.2f, 1.0f },
+    { "hit.wav"_hs,     "hit",     5, 3, 0.3f, 2.0f },
+    { "hurt.wav"_hs,    "hurt",    4, 2, 0.4f, 3.0f },
+    { "boom.wav"_hs,    "boom",    5, 3, 1.0f, 4.0f },
+    { "beep.wav"_hs,    "beep",    0, 1, 0.2f, 6.0f },
+    { "nope.wav"_hs,    "nope",    0, 1, 0.3f, 8.0f },
+    { "drop.wav"_hs,    "drop",    0, 1, 0.5f, 8.0f },
+    { "alert.wav"_hs,   "alert",   0, 1, 1.5f, 8.0f },
+    { "nuke.wav"_hs,    "nuke",    0, 1, 2.0f, 9.0f },
+    { "dead.wav"_hs,    "dead",    0, 1, 2.0f, 10.0f },
+  };
+
+  constexpr size_t kGroupCount = sizeof(kGroups) / sizeof(kGroups[0]);
+
+  size_t find_group(Assets::Id id) {
+    for (size_t i = 0; i < kGroupCount; ++i) {
+      if (kGroups[i].id == id) return i;
+    }
+    return kGroupCount;
+  }
+}
+
+SoundQueue::SoundQueue() : voices_(), listener_(), time_(0), played_(0), dropped_(0) {
+  requests_.reserve(kGroupCount);
+
+  // resolve every variant to its resident sample once, names are only built here
+  slots_.resize(kGroupCount);
+  for (size_t i = 0; i < kGroupCount; ++i) {
+    const Group& g = kGroups[i];
+    if (g.variants == 0) {
+      slots_[i].push_back(Assets::sample(entt::hashed_string::value((std::string(g.stem) + ".wav").c_str())));
+    } else {
+      for (size_t v = 0; v < g.variants; ++v) {
+        slots_[i].push_back(Assets::sample(entt::hashed_string::value((g.stem + std::to_string(v) + ".wav").c_str())));
+      }
+    }
+  }
+}
+
+void SoundQueue::play(Assets::Id sample) {
+  request(find_group(sample), 0.0f);
+}
+
+void SoundQueue::play(Assets::Id sample, pos source) {
+  request(find_group(sample), std::sqrt(source.dist2(listener_)));
+}
+
+void SoundQueue::request(size_t group, float distance) {
+  if (group == kGroupCount) return;
+
+  for (auto& r : requests_) {
+    if (r.group != group) continue;
+
+    // merge, keeping whichever request was closest
+    r.distance = std::min(r.distance, distance);
+    return;
+  }
+
+  requests_.push_back({ group, distance, 0.0f });
+}
+
+void SoundQueue::flush(Audio& audio, float t) {
+  TRACE_SCOPE("SoundQueue::flush");
+
+  time_ += t;
+  played_ = 0;
+  dropped_ = 0;
+
+  for (auto& r : requests_) {
+    r.score = kGroups[r.group].priority * (1.0f - r.distance / kFalloff);
+  }
+
+  std::sort(requests_.begin(), requests_.end(),
+      [](const Request& a, const Request& b) { return a.score > b.score; });
+
+  for (const auto& r : requests_) {
+    const Group& g = kGroups[r.group];
+
+    size_t in_group = 0;
+    Voice* free = nullptr;
+    for (auto& v : voices_) {
+      if (v.end <= time_) {
+        if (!free) free = &v;
+      } else if (v.group == r.group) {
+        ++in_group;
+      }
+    }
+
+    if (r.score <= 0 || in_group >= g.voices || !free) {
+      ++dropped_;
+      continue;
+    }
+
+    *free = { r.group, time_ + g.length };
+    ++played_;
+
+    const auto& slots = slots_[r.group];
+    const uint8_t distance = (uint8_t)std::min(255.0f, 255.0f * r.distance / kFalloff);
+    Assets::play_sample(audio, slots[slots.size() > 1 ? rng_.range(0, (int)slots.size() - 1) : 0], distance);
+  }
+
+  requests_.clear();
+
+  Trace::counter("sounds played", played_);
+  Trace::counter("sounds dropped", dropped_);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "assets.h"
+#include "audio.h"
+#include "geometry.h"
+#include "rng.h"
+
+// Collects the sample requests made during a frame and decides which of
+// them get played.  Identical requests in one frame are merged, each
+// sample group has a voice cap, and when there are more candidates than
+// free voices the highest priority, closest sounds win.
+class SoundQueue {
+  public:
+
+    SoundQueue();
+
+    // positional sounds rank lower and play quieter the further they are
+    // from the listener, silent and dropped past kFalloff
+    void listen(pos listener) { listener_ = listener; }
+
+    // samples are named by group, "boom.wav"_hs picks one of boom0-4.wav
+    void play(Assets::Id sample);
+    void play(Assets::Id sample, pos source);
+
+    // plays the winners of this frame and clears the queue
+    void flush(Audio& audio, float t);
+
+    size_t played() const { return played_; }
+    size_t dropped() const { return dropped_; }
+
+  private:
+
+    static constexpr size_t kMaxVoices = 8;
+    static constexpr float kFalloff = 1500.0f;
+
+    struct Request {
+      size_t group;
+      float distance;
+      float score;
+    };
+
+    struct Voice {
+      size_t group;
+      float end;
+    };
+
+    std::vector<std::vector<size_t>> slots_;
+    std::vector<Request> requests_;
+    std::array<Voice, kMaxVoices> voices_;
+    pos listener_;
+    Rng rng_;
+    float time_;
+    size_t played_, dropped_;
+
+    void request(size_t group, float distance);
+};
@@ -1,15 +1,19 @@
 #include "space.h"
 
 #include "config.h"
+#include "quality.h"
+#include "rng.h"
+#include "trace.h"
 
-Space::Space(uint64_t seed) : rng_(seed) {
-  std::uniform_real_distribution<float> px(0, (float)kConfig.graphics.width);
-  std::uniform_real_distribution<float> py(0, (float)kConfig.graphics.height);
-  std::uniform_real_distribution<float> hue(0, 360);
-  std::uniform_int_distribution<int> layer(1, 6);
+Space::Space(uint64_t seed) : offset_(0) {
+  TRACE_SCOPE("Space::Space");
+  Rng rng(seed);
 
   for (size_t i = 0; i < 1500; ++i) {
-    stars_.push_back({px(rng_), py(rng_), layer(rng_), hsl{hue(rng_), 1.0f, 0.85f}});
+    const float x = rng.uniform(0, (float)kConfig.graphics.width);
+    const float y = rng.uniform(0, (float)kConfig.graphics.height);
+    const int layer = rng.range(1, 6);
+    stars_.push_back({x, y, layer, hsl{rng.uniform(0, 360), 1.0f, 0.85f}});
   }
 }
 
@@ -18,7 +22,11 @@ void Space::update(float t) {
 }
 
 void Space::draw(Graphics& graphics) const {
-  for (const auto s : stars_) {
+  TRACE_SCOPE("Space::draw");
+  // stars are in random order so any prefix is an even thinning
+  const size_t shown = Quality::scale(stars_.size());
+  for (size_t i = 0; i < shown; ++i) {
+    const Star& s = stars_[i];
     const int px = (int)(s.x + offset_ * s.layer) % graphics.width();
     graphics.draw_pixel({px, (int)s.y}, s.color);
   }
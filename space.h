@@ -1,6 +1,6 @@
 #pragma once
 
-#include <random>
+#include <cstdint>
 #include <vector>
 
 #include "graphics.h"
@@ -22,7 +22,6 @@ class Space {
       uint32_t color;
     };
 
-    mutable std::mt19937 rng_;
     std::vector<Star> stars_;
     float offset_;
 };
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+
+// Entity creation spread over frames.  Requests say what to create and how
+// many, and each frame drain hands out a fixed number of entities, so a
+// bomb that kills thirty ships costs a few frames of particles instead of
+// one frame of fifteen thousand.  Gameplay requests are served before any
+// cosmetic ones and the oldest is always finished whole, so nothing that
+// can hit the player is ever starved.  Cosmetic requests that have waited
+// too long are dropped rather than shown late.
+template <typename T> class SpawnQueue {
+  public:
+
+    enum class Priority { gameplay, cosmetic };
+
+    SpawnQueue(size_t budget, size_t max_age) :
+      budget_(budget), max_age_(max_age), pending_(0), dropped_(0) {}
+
+    void push(Priority priority, const T& request, size_t count) {
+      if (count == 0) return;
+      (priority == Priority::gameplay ? gameplay_ : cosmetic_).push_back({ request, count, 0 });
+      pending_ += count;
+    }
+
+    // calls f(request, n) to create the next n entities of a request, n may
+    // be less than the request asked for when the budget runs out
+    template <typename F> void drain(F f) {
+      size_t left = budget_;
+      take(gameplay_, left, f, true);
+      take(cosmetic_, left, f, false);
+
+      while (!cosmetic_.empty() && cosmetic_.front().age >= max_age_) {
+        pending_ -= cosmetic_.front().count;
+        dropped_ += cosmetic_.front().count;
+        cosmetic_.pop_front();
+      }
+      for (auto& entry : cosmetic_) ++entry.age;
+    }
+
+    // entities still waiting to be created
+    size_t pending() const { return pending_; }
+    size_t dropped() const { return dropped_; }
+
+    // everything still waiting through an archive that's called with one
+    // value at a time, requests are written whole
+    template <typename Archive> void save(Archive& archive) const {
+      archive(pending_);
+      archive(dropped_);
+      write(archive, gameplay_);
+      write(archive, cosmetic_);
+    }
+
+    template <typename Archive> void load(Archive& archive) {
+      archive(pending_);
+      archive(dropped_);
+      read(archive, gameplay_);
+      read(archive, cosmetic_);
+    }
+
+  private:
+
+    struct Entry {
+      T request;
+      size_t count, age;
+    };
+
+    size_t budget_, max_age_;
+    size_t pending_, dropped_;
+    std::deque<Entry> gameplay_, cosmetic_;
+
+    template <typename Archive> static void write(Archive& archive, const std::deque<Entry>& lane) {
+      archive((uint64_t)lane.size());
+      for (const auto& entry : lane) {
+        archive(entry.request);
+        archive(entry.count);
+        archive(entry.age);
+      }
+    }
+
+    template <typename Archive> static void read(Archive& archive, std::deque<Entry>& lane) {
+      uint64_t size = 0;
+      archive(size);
+      lane.resize(size);
+      for (auto& entry : lane) {
+        archive(entry.request);
+        archive(entry.count);
+        archive(entry.age);
+      }
+    }
+
+    template <typename F> void take(std::deque<Entry>& lane, size_t& left, F& f, bool finish_first) {
+      while (!lane.empty()) {
+        Entry& entry = lane.front();
+        const size_t n = finish_first ? entry.count : std::min(entry.count, left);
+        if (n == 0) return;
+
+        f(entry.request, n);
+        finish_first = false;
+        left -= std::min(n, left);
+        pending_ -= n;
+        entry.count -= n;
+        if (entry.count > 0) return;
+        lane.pop_front();
+      }
+    }
+};
@@ -0,0 +1,64 @@
+#include "sweep.h"
+
+#include "trace.h"
+
+namespace {
+  constexpr size_t kNone = (size_t)-1;
+}
+
+void Sweep::update(const std::vector<Bounds>& bounds) {
+  TRACE_SCOPE("Sweep::update");
+  const auto before = [](const Entry& a, const Entry& b) { return a.min.x < b.min.x; };
+
+  widest_ = 0;
+  for (size_t i = 0; i < bounds.size(); ++i) {
+    const size_t id = entt::to_entity(bounds[i].e);
+    if (id >= slots_.size()) slots_.resize(id + 1, kNone);
+    slots_[id] = i;
+    widest_ = std::max(widest_, bounds[i].max.x - bounds[i].min.x);
+  }
+
+  // survivors in last frame's order, with a recycled index only counting as
+  // the same entity when the version matches too
+  kept_.clear();
+  for (const auto& entry : entries_) {
+    const size_t id = entt::to_entity(entry.e);
+    const size_t i = id < slots_.size() ? slots_[id] : kNone;
+    if (i == kNone || bounds[i].e != entry.e) continue;
+    kept_.push_back({ entry.e, i, bounds[i].min, bounds[i].max });
+    slots_[id] = kNone;
+  }
+
+  added_.clear();
+  for (size_t i = 0; i < bounds.size(); ++i) {
+    const size_t id = entt::to_entity(bounds[i].e);
+    if (slots_[id] != i) continue;
+    added_.push_back({ bounds[i].e, i, bounds[i].min, bounds[i].max });
+    slots_[id] = kNone;
+  }
+
+  // nearly sorted already, so each entry only moves a few places
+  moves_ = 0;
+  for (size_t i = 1; i < kept_.size(); ++i) {
+    const Entry entry = kept_[i];
+    size_t j = i;
+    for (; j > 0 && before(entry, kept_[j - 1]); --j) kept_[j] = kept_[j - 1];
+    kept_[j] = entry;
+    moves_ += i - j;
+  }
+
+  // a spawn wave lands all at once in no particular place, sorting it on its
+  // own and merging is cheaper than walking each one down the list
+  std::sort(added_.begin(), added_.end(), before);
+  entries_.resize(kept_.size() + added_.size());
+  std::merge(kept_.begin(), kept_.end(), added_.begin(), added_.end(), entries_.begin(), before);
+
+  pairs_.clear();
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const Entry& a = entries_[i];
+    for (size_t j = i + 1; j < entries_.size() && entries_[j].min.x <= a.max.x; ++j) {
+      const Entry& b = entries_[j];
+      if (b.min.y <= a.max.y && a.min.y <= b.max.y) pairs_.push_back({ a.index, b.index });
+    }
+  }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "entt/entity/registry.hpp"
+
+#include "geometry.h"
+
+// Sweep and prune broad phase.  Bounds stay sorted on x from one frame to
+// the next, and since nothing moves far in a frame an insertion sort puts
+// them back in order in close to linear time.  Sweeping the sorted list only
+// compares bounds that overlap on x, and a y test drops most of those before
+// a pair is reported, so the narrow phase sees a handful of candidates
+// instead of every pair.
+class Sweep {
+  public:
+
+    struct Bounds { entt::entity e; pos min, max; };
+    // indices into the bounds given to the last update
+    struct Pair { size_t a, b; };
+
+    // replaces the tracked set, entities that were there last frame keep
+    // their place in the sorted order
+    void update(const std::vector<Bounds>& bounds);
+
+    // every overlapping pair, in sweep order
+    const std::vector<Pair>& pairs() const { return pairs_; }
+
+    // calls f with the index of each bound containing p until f returns true
+    template <typename F> void query(const pos& p, F f) const {
+      const auto first = std::lower_bound(entries_.begin(), entries_.end(), p.x - widest_,
+          [](const Entry& entry, float x) { return entry.min.x < x; });
+      for (auto it = first; it != entries_.end() && it->min.x <= p.x; ++it) {
+        if (p.x > it->max.x || p.y < it->min.y || p.y > it->max.y) continue;
+        if (f(it->index)) return;
+      }
+    }
+
+    // how far the insertion sort moved entries, low while frames are coherent
+    size_t moves() const { return moves_; }
+
+  private:
+
+    struct Entry { entt::entity e; size_t index; pos min, max; };
+
+    std::vector<Entry> entries_, kept_, added_;
+    // by entity index, where its bounds are in the current update
+    std::vector<size_t> slots_;
+    std::vector<Pair> pairs_;
+    float widest_ = 0;
+    size_t moves_ = 0;
+};
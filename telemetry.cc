@@ -0,0 +1,130 @@
+#include "telemetry.h"
+
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include "trace.h"
+
+namespace {
+  constexpr float kInterval = 1.0f;
+  constexpr size_t kWindow = 60;
+  // consecutive windows with a higher floor before a series is flagged
+  constexpr size_t kRising = 3;
+  // ignore small drifts, over those windows the floor has to rise by both
+  constexpr size_t kMinStep = 16;
+  constexpr float kMinRatio = 1.1f;
+
+  struct Series {
+    const char* name;
+    size_t low = std::numeric_limits<size_t>::max();
+    size_t floor = 0, first = 0;
+    size_t windows = 0, rising = 0;
+    bool flagged = false;
+
+    void add(size_t value) {
+      low = std::min(low, value);
+    }
+
+    // returns true the first time the series is flagged
+    bool close() {
+      const size_t previous = floor;
+      floor = low;
+      low = std::numeric_limits<size_t>::max();
+
+      if (windows++ == 0) return false;
+      if (floor > previous) {
+        if (rising++ == 0) first = previous;
+      } else {
+        rising = 0;
+      }
+
+      if (flagged || rising < kRising) return false;
+      if (floor < first + kMinStep || floor < first * kMinRatio) return false;
+      flagged = true;
+      return true;
+    }
+  };
+
+  FILE* csv = nullptr;
+  bool started = false, show = false;
+  float game_time = 0, next = 0;
+  size_t samples = 0;
+  std::vector<Series> series;
+  std::vector<Telemetry::Growth> flagged;
+
+  void watch(size_t i, const char* name, size_t value) {
+    if (i == series.size()) series.push_back({ name });
+    series[i].add(value);
+  }
+}
+
+void Telemetry::start(const std::string& path, bool overlay) {
+  if (started) return;
+
+  if (!path.empty()) {
+    csv = fopen(path.c_str(), "w");
+    if (csv) fprintf(csv, "time_s,name,size,capacity,bytes\n");
+  }
+
+  show = overlay;
+  started = true;
+}
+
+void Telemetry::stop() {
+  if (!started) return;
+  started = false;
+
+  if (csv) {
+    fclose(csv);
+    csv = nullptr;
+  }
+
+  for (const auto& g : flagged) {
+    fprintf(stderr, "telemetry: %s kept growing, its floor rose from %zu to %zu\n", g.name, g.from, g.to);
+  }
+}
+
+bool Telemetry::overlay() {
+  return show;
+}
+
+void Telemetry::update(float t, size_t entities, const std::vector<PoolBudget::Stats>& pools) {
+  if (!started) return;
+
+  game_time += t;
+  if (game_time < next) return;
+  next = game_time + kInterval;
+
+  TRACE_SCOPE("Telemetry::update");
+
+  size_t bytes = 0;
+  if (csv) fprintf(csv, "%.1f,entities,%zu,0,0\n", game_time, entities);
+  for (const auto& p : pools) {
+    if (csv) fprintf(csv, "%.1f,%s,%zu,%zu,%zu\n", game_time, p.name, p.size, p.capacity, p.bytes);
+    bytes += p.bytes;
+  }
+
+  watch(0, "entities", entities);
+  watch(1, "pool bytes", bytes);
+  for (size_t i = 0; i < pools.size(); ++i) watch(i + 2, pools[i].name, pools[i].size);
+
+  if (++samples % kWindow != 0) return;
+  for (auto& s : series) {
+    if (!s.close()) continue;
+    flagged.push_back({ s.name, s.first, s.floor });
+    fprintf(stderr, "telemetry: %s is growing, floor %zu to %zu over %zu minutes\n", s.name, s.first, s.floor, kRising);
+  }
+  Trace::counter("growing series", flagged.size());
+}
+
+const std::vector<Telemetry::Growth>& Telemetry::growing() {
+  return flagged;
+}
+
+bool Telemetry::growing(const char* name) {
+  for (const auto& s : series) {
+    if (strcmp(s.name, name) == 0) return s.flagged;
+  }
+  return false;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "pool_budget.h"
+
+// Registry population over a long session.  Once a second of game time the
+// entity count and every pool's size, capacity and bytes are sampled and,
+// with a path, appended to a CSV time series.  Tag components have empty
+// pools, so their sizes are the entity counts by tag.  Each series keeps
+// the floor of every minute of samples; a floor that keeps rising minute
+// after minute is what a leak looks like under normal churn, and flags the
+// series as growing.
+namespace Telemetry {
+  struct Growth {
+    const char* name;
+    size_t from, to;
+  };
+
+  // an empty path samples and watches for growth without writing a file
+  void start(const std::string& path, bool overlay);
+  // closes the file and reports anything flagged as growing to stderr
+  void stop();
+
+  bool overlay();
+
+  // call once per frame with the registry's entity count and pool stats
+  void update(float t, size_t entities, const std::vector<PoolBudget::Stats>& pools);
+
+  // series flagged so far, with the floors the growth was first seen between
+  const std::vector<Growth>& growing();
+  bool growing(const char* name);
+}
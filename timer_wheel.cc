@@ -0,0 +1,40 @@
+#include "timer_wheel.h"
+
+#include <cmath>
+
+TimerWheel::TimerWheel(float tick) : tick_(tick), current_(0), size_(0) {}
+
+void TimerWheel::schedule(entt::entity e, float at) {
+  place({ e, (uint64_t)std::ceil(at / tick_) });
+  ++size_;
+}
+
+void TimerWheel::place(const Entry& entry) {
+  // anything already due goes in the slot about to be processed
+  const uint64_t tick = entry.tick > current_ ? entry.tick : current_;
+  const uint64_t delta = tick - current_;
+
+  if (delta < kSlots) {
+    inner_[tick % kSlots].push_back(entry.e);
+  } else if (delta < kSlots * kOuterSlots) {
+    outer_[(tick / kSlots) % kOuterSlots].push_back({ entry.e, tick });
+  } else {
+    overflow_.push_back({ entry.e, tick });
+  }
+}
+
+void TimerWheel::cascade() {
+  const uint64_t round = current_ / kSlots;
+
+  // a full turn of the outer wheel brings the overflow back in range
+  if (round % kOuterSlots == 0 && !overflow_.empty()) {
+    std::vector<Entry> waiting;
+    waiting.swap(overflow_);
+    for (const auto& entry : waiting) place(entry);
+  }
+
+  auto& slot = outer_[round % kOuterSlots];
+  std::vector<Entry> moving;
+  moving.swap(slot);
+  for (const auto& entry : moving) place(entry);
+}
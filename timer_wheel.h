@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "entt/entity/registry.hpp"
+
+// Two level hierarchical timing wheel keyed on absolute expiry time.  The
+// inner wheel has one slot per tick and covers the next few seconds, which
+// is every particle and flash, the outer wheel holds one slot per inner
+// revolution and is cascaded down as the inner wheel comes around.  Anything
+// further out waits in an overflow list.  Advancing only visits the slots
+// that came due, never the entities that are still waiting.
+class TimerWheel {
+  public:
+
+    explicit TimerWheel(float tick);
+
+    void schedule(entt::entity e, float at);
+
+    // calls f with every entity due at or before now, in no particular order
+    template <typename F> void advance(float now, F f) {
+      const uint64_t target = (uint64_t)(now / tick_);
+      for (; current_ <= target; ++current_) {
+        if (current_ % kSlots == 0) cascade();
+
+        auto& slot = inner_[current_ % kSlots];
+        for (const auto e : slot) f(e);
+        size_ -= slot.size();
+        slot.clear();
+      }
+    }
+
+    size_t size() const { return size_; }
+
+    // the whole wheel, slot by slot, through an archive that's called with
+    // one value at a time; load takes back what save wrote
+    template <typename Archive> void save(Archive& archive) const {
+      archive(current_);
+      archive(size_);
+      for (const auto& slot : inner_) write(archive, slot);
+      for (const auto& slot : outer_) write(archive, slot);
+      write(archive, overflow_);
+    }
+
+    template <typename Archive> void load(Archive& archive) {
+      archive(current_);
+      archive(size_);
+      for (auto& slot : inner_) read(archive, slot);
+      for (auto& slot : outer_) read(archive, slot);
+      read(archive, overflow_);
+    }
+
+  private:
+
+    static constexpr uint64_t kSlots = 256;
+    static constexpr uint64_t kOuterSlots = 64;
+
+    struct Entry {
+      entt::entity e;
+      uint64_t tick;
+    };
+
+    float tick_;
+    uint64_t current_;
+    size_t size_;
+
+    std::array<std::vector<entt::entity>, kSlots> inner_;
+    std::array<std::vector<Entry>, kOuterSlots> outer_;
+    std::vector<Entry> overflow_;
+
+    void place(const Entry& entry);
+    void cascade();
+
+    // entries field by field, the padding isn't part of the state
+    template <typename Archive> static void write(Archive& archive, const std::vector<entt::entity>& slot) {
+      archive((uint64_t)slot.size());
+      for (const auto e : slot) archive(e);
+    }
+
+    template <typename Archive> static void write(Archive& archive, const std::vector<Entry>& slot) {
+      archive((uint64_t)slot.size());
+      for (const auto& entry : slot) {
+        archive(entry.e);
+        archive(entry.tick);
+      }
+    }
+
+    template <typename Archive> static void read(Archive& archive, std::vector<entt::entity>& slot) {
+      uint64_t size = 0;
+      archive(size);
+      slot.resize(size);
+      for (auto& e : slot) archive(e);
+    }
+
+    template <typename Archive> static void read(Archive& archive, std::vector<Entry>& slot) {
+      uint64_t size = 0;
+      archive(size);
+      slot.resize(size);
+      for (auto& entry : slot) {
+        archive(entry.e);
+        archive(entry.tick);
+      }
+    }
+};
@@ -2,11 +2,22 @@
 
 #include "util.h"
 
+#include "assets.h"
 #include "game_screen.h"
+#include "pacing.h"
+#include "quality.h"
+#include "trace.h"
 
-TitleScreen::TitleScreen() : text_("text.png", 16), title_("hydra.png", 5, 200, 200), space_(Util::random_seed()), counter_(0) {}
+using namespace entt::literals;
+
+TitleScreen::TitleScreen() : text_(Assets::text("text.png"_hs)), title_(Assets::sprites("hydra.png"_hs)), space_(starfield()), counter_(0) {}
 
 bool TitleScreen::update(const Input& input, Audio&, unsigned int elapsed) {
+  TRACE_SCOPE("TitleScreen::update");
+  const Quality::Work work(Quality::Phase::update);
+  Pacing::snapshot({ 0, 0, 0, 0, "title" });
+  // finish the samples here so starting a game doesn't wait on them
+  Assets::poll();
   const float t = elapsed / 1000.0f;
   counter_ += t;
   space_.update(10 * t);
@@ -28,6 +39,8 @@ bool TitleScreen::update(const Input& input, Audio&, unsigned int elapsed) {
 }
 
 void TitleScreen::draw(Graphics& graphics) const {
+  TRACE_SCOPE("TitleScreen::draw");
+  const Quality::Work work(Quality::Phase::draw);
   space_.draw(graphics);
 
   for (size_t i = 0; i < 5; ++ i) {
@@ -49,6 +62,7 @@ void TitleScreen::draw(Graphics& graphics) const {
 }
 
 Screen* TitleScreen::next_screen() const {
+  TRACE_SCOPE("TitleScreen::next_screen");
   return new GameScreen;
 }
 
@@ -68,3 +82,10 @@ void TitleScreen::load_story_text() {
 
   story_timeout_ = 24.0f;
 }
+
+Space& TitleScreen::starfield() {
+  // built once and kept for the life of the process so coming back to the
+  // title screen doesn't regenerate 1500 stars
+  static Space space(Util::random_seed());
+  return space;
+}
@@ -21,9 +21,9 @@ class TitleScreen : public Screen {
 
   private:
 
-    Text text_;
-    SpriteMap title_;
-    Space space_;
+    const Text& text_;
+    const SpriteMap& title_;
+    Space& space_;
     Dialog dialog_;
 
     float counter_, story_timeout_;
@@ -31,4 +31,6 @@ class TitleScreen : public Screen {
 
     void load_story_text();
 
+    static Space& starfield();
+
 };
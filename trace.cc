@@ -0,0 +1,132 @@
+#include "trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace {
+  struct Event {
+    const char* name;
+    char phase;
+    int64_t value;
+    std::chrono::steady_clock::time_point time;
+  };
+
+  // Each thread owns a chain of fixed size chunks.  Only the owning thread
+  // writes; the count is published with release so the writer never has to
+  // wait on the thread that flushes the trace.
+  struct Chunk {
+    static constexpr size_t kSize = 16384;
+
+    Event events[kSize];
+    std::atomic<size_t> count{0};
+    std::atomic<Chunk*> next{nullptr};
+  };
+
+  struct Buffer {
+    int tid;
+    Chunk* head;
+    Chunk* tail;
+  };
+
+  std::atomic<bool> active{false};
+  std::chrono::steady_clock::time_point epoch;
+  std::string output;
+
+  std::mutex buffers_mutex;
+  std::vector<Buffer*> buffers;
+
+  Buffer& local_buffer() {
+    thread_local Buffer* buffer = nullptr;
+    if (!buffer) {
+      const std::lock_guard<std::mutex> lock(buffers_mutex);
+      Chunk* chunk = new Chunk();
+      buffer = new Buffer{(int)buffers.size() + 1, chunk, chunk};
+      buffers.push_back(buffer);
+    }
+    return *buffer;
+  }
+
+  void record(const char* name, char phase, int64_t value) {
+    Buffer& buffer = local_buffer();
+    Chunk* chunk = buffer.tail;
+    size_t n = chunk->count.load(std::memory_order_relaxed);
+
+    if (n == Chunk::kSize) {
+      Chunk* next = new Chunk();
+      chunk->next.store(next, std::memory_order_release);
+      buffer.tail = chunk = next;
+      n = 0;
+    }
+
+    chunk->events[n] = { name, phase, value, std::chrono::steady_clock::now() };
+    chunk->count.store(n + 1, std::memory_order_release);
+  }
+
+  void write_event(FILE* f, const Event& e, int tid, bool& first) {
+    const double ts = std::chrono::duration<double, std::micro>(e.time - epoch).count();
+
+    fputs(first ? "\n" : ",\n", f);
+    first = false;
+
+    if (e.phase == 'C') {
+      fprintf(f, "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"value\":%lld}}",
+          e.name, ts, tid, (long long)e.value);
+    } else {
+      fprintf(f, "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+          e.name, e.phase, ts, tid);
+    }
+  }
+}
+
+void Trace::start(const std::string& path) {
+  output = path;
+  epoch = std::chrono::steady_clock::now();
+  // the starting thread takes tid 1, which is labelled main, before the
+  // asset loader or a worker can record first
+  local_buffer();
+  active.store(true, std::memory_order_release);
+}
+
+void Trace::stop() {
+  if (!active.exchange(false)) return;
+
+  FILE* f = fopen(output.c_str(), "w");
+  if (!f) return;
+
+  const std::lock_guard<std::mutex> lock(buffers_mutex);
+
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", f);
+  bool first = true;
+  for (const Buffer* buffer : buffers) {
+    fputs(first ? "\n" : ",\n", f);
+    first = false;
+    fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+        buffer->tid, buffer->tid == 1 ? "main" : "worker");
+
+    for (const Chunk* c = buffer->head; c; c = c->next.load(std::memory_order_acquire)) {
+      const size_t n = c->count.load(std::memory_order_acquire);
+      for (size_t i = 0; i < n; ++i) write_event(f, c->events[i], buffer->tid, first);
+    }
+  }
+  fputs("\n]}\n", f);
+  fclose(f);
+}
+
+bool Trace::enabled() {
+  return active.load(std::memory_order_relaxed);
+}
+
+void Trace::begin(const char* name) {
+  record(name, 'B', 0);
+}
+
+void Trace::end(const char* name) {
+  record(name, 'E', 0);
+}
+
+void Trace::counter(const char* name, int64_t value) {
+  if (enabled()) record(name, 'C', value);
+}
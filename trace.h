@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "alloc.h"
+
+// Chrome trace-event recorder.  Spans and counters are appended to a
+// per-thread buffer without locking and written out as JSON (loadable in
+// Perfetto or chrome://tracing) when the trace is stopped.  Nothing is
+// recorded until Trace::start is called.  Scopes also attribute heap
+// allocations in instrumented builds, see alloc.h.
+namespace Trace {
+  // call from the main thread, which the trace labels by the caller
+  void start(const std::string& path);
+  void stop();
+  bool enabled();
+
+  // names must be string literals, only the pointer is stored
+  void begin(const char* name);
+  void end(const char* name);
+  void counter(const char* name, int64_t value);
+
+  class Scope {
+    public:
+      explicit Scope(const char* name) : name_(name), traced_(enabled()) {
+        Alloc::push(name_);
+        if (traced_) begin(name_);
+      }
+
+      ~Scope() {
+        if (traced_) end(name_);
+        Alloc::pop();
+      }
+
+      Scope(const Scope&) = delete;
+      Scope& operator=(const Scope&) = delete;
+
+    private:
+      const char* name_;
+      bool traced_;
+  };
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) const Trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
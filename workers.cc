@@ -0,0 +1,144 @@
+#include "workers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "trace.h"
+
+namespace {
+  class Pool {
+    public:
+
+      ~Pool() { stop(); }
+
+      void start(size_t threads) {
+        stop();
+        quit_ = false;
+        started_ = true;
+        for (size_t i = 1; i < threads; ++i) threads_.emplace_back(&Pool::loop, this, i);
+      }
+
+      void stop() {
+        {
+          const std::lock_guard<std::mutex> lock(mutex_);
+          quit_ = true;
+        }
+        wake_.notify_all();
+        for (auto& t : threads_) t.join();
+        threads_.clear();
+      }
+
+      size_t count() const { return threads_.size() + 1; }
+      bool started() const { return started_; }
+
+      void run(size_t n, size_t chunk, const Workers::Range& f) {
+        {
+          const std::lock_guard<std::mutex> lock(mutex_);
+          job_ = &f;
+          size_ = n;
+          chunk_ = chunk;
+          next_ = 0;
+          pending_ = threads_.size();
+          ++generation_;
+        }
+        wake_.notify_all();
+
+        work(0, n, chunk, f);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return pending_ == 0; });
+        job_ = nullptr;
+      }
+
+    private:
+
+      std::vector<std::thread> threads_;
+      std::mutex mutex_;
+      std::condition_variable wake_, done_;
+
+      const Workers::Range* job_ = nullptr;
+      size_t size_ = 0, chunk_ = 0;
+      std::atomic<size_t> next_{0};
+      size_t pending_ = 0;
+      uint64_t generation_ = 0;
+      bool quit_ = false, started_ = false;
+
+      void work(size_t worker, size_t n, size_t chunk, const Workers::Range& f) {
+        for (;;) {
+          const size_t begin = next_.fetch_add(chunk);
+          if (begin >= n) return;
+          f(begin, std::min(n, begin + chunk), worker);
+        }
+      }
+
+      void loop(size_t worker) {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+          wake_.wait(lock, [&] { return quit_ || generation_ != seen; });
+          if (quit_) return;
+          seen = generation_;
+
+          const Workers::Range& f = *job_;
+          const size_t n = size_, chunk = chunk_;
+          lock.unlock();
+          work(worker, n, chunk, f);
+          lock.lock();
+
+          if (--pending_ == 0) done_.notify_one();
+        }
+      }
+  };
+
+  Pool& pool() {
+    static Pool pool;
+    return pool;
+  }
+
+  // the default pool, unless start() already picked a size, so count() and
+  // the worker indices parallel_for hands out always agree
+  Pool& started() {
+#ifndef __EMSCRIPTEN__
+    static std::once_flag once;
+    std::call_once(once, [] { if (!pool().started()) Workers::start(); });
+#endif
+    return pool();
+  }
+}
+
+void Workers::start(size_t threads) {
+#ifndef __EMSCRIPTEN__
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  pool().start(threads);
+#else
+  (void)threads;
+#endif
+}
+
+void Workers::stop() {
+  pool().stop();
+}
+
+size_t Workers::count() {
+  return started().count();
+}
+
+void Workers::parallel_for(size_t count, size_t grain, const Range& f) {
+  if (count == 0) return;
+
+  Pool& p = started();
+  if (p.count() == 1 || count <= grain) {
+    f(0, count, 0);
+    return;
+  }
+
+  // a few chunks per worker so an uneven split still balances out
+  const size_t chunk = std::max(grain, (count + p.count() * 4 - 1) / (p.count() * 4));
+  TRACE_SCOPE("Workers::parallel_for");
+  p.run(count, chunk, f);
+}
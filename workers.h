@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Process wide pool of worker threads for splitting independent per-entity
+// work across cores.  The calling thread takes part in every job, so count()
+// includes it.  Builds without threads (emscripten) run everything inline.
+namespace Workers {
+  using Range = std::function<void(size_t begin, size_t end, size_t worker)>;
+
+  // 0 picks one thread per core, count() and parallel_for start the default
+  // pool on first use so this is only needed to pick a different size
+  void start(size_t threads = 0);
+  void stop();
+  size_t count();
+
+  // splits [0, count) into chunks of at least grain items and blocks until
+  // all of them have run.  worker is below count() and no two chunks running
+  // at the same time share one, so it can index per-thread scratch space.
+  void parallel_for(size_t count, size_t grain, const Range& f);
+}